@@ -0,0 +1,343 @@
+// Microbenchmarks of the single detection stages, the full detection and the pose optimization.
+//
+// Run with a fixed CPU frequency and e.g. --benchmark_repetitions=10 to get comparable numbers:
+//   ./stargazer_benchmark --benchmark_filter=DetectLandmarks
+//
+// Synthetic scenes place Hagisonic landmarks of the test map on a regular grid of a black image,
+// each LED a bright spot. Noise blobs are single spots at random positions, that do not belong to
+// any landmark. All random numbers come from fixed seeds, so every run sees the same inputs.
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "CeresLocalizer.h"
+#include "LandmarkFinder.h"
+
+namespace stargazer {
+
+/**
+ * @brief Runs the private stages of a LandmarkFinder one by one
+ */
+class LandmarkFinderStages {
+ public:
+  typedef LandmarkFinder::ScratchPoints ScratchPoints;
+  typedef LandmarkFinder::ScratchClusters ScratchClusters;
+
+  explicit LandmarkFinderStages(const LandmarkFinder& finder) : finder_(finder) {}
+
+  void FindBlobs(LandmarkFinder::Workspace& workspace, ScratchPoints& points) const {
+    finder_.FindBlobs(workspace, points);
+  }
+
+  void FindClusters(const ScratchPoints& points,
+                    ScratchClusters& clusters,
+                    unsigned int max_points) const {
+    finder_.FindClusters(points, clusters, finder_.maxRadiusForCluster, finder_.minPointsPerLandmark,
+                         max_points);
+  }
+
+  void FindCorners(const ScratchClusters& clusters,
+                   std::pmr::memory_resource* arena,
+                   std::vector<ImgLandmark>& hypotheses) const {
+    for (size_t c = 0; c < clusters.size(); c++) {
+      finder_.FindCorners(clusters[c], arena, hypotheses);
+    }
+  }
+
+  void GetIDs(std::vector<ImgLandmark>& landmarks, LandmarkFinder::Workspace& workspace) const {
+    finder_.GetIDs<LandmarkFamily4x4>(landmarks, workspace);
+  }
+
+ private:
+  const LandmarkFinder& finder_;
+};
+
+}  // namespace stargazer
+
+using namespace stargazer;
+
+namespace {
+
+const std::string kResDir = STARGAZER_RES_DIR;
+constexpr int kLedRadius = 3;       /**< Radius of a rendered LED in pixels */
+constexpr int kLedSpacing = 10;     /**< Distance between adjacent LEDs in pixels */
+constexpr int kLandmarkSpacing = 100; /**< Distance between adjacent landmarks in pixels */
+
+LandmarkMap::ConstPtr testMap() {
+  static const LandmarkMap::ConstPtr map = std::make_shared<const LandmarkMap>(kResDir + "/map.yaml");
+  return map;
+}
+
+/**
+ * @brief ID of a 4x4 landmark with the given number of inner points
+ */
+landmark_id_t syntheticId(int id_points) {
+  landmark_id_t id = 0;
+  for (int y = 0; y < LandmarkFamily4x4::kGridCount && id_points > 0; y++) {
+    for (int x = 0; x < LandmarkFamily4x4::kGridCount && id_points > 0; x++) {
+      if (!LandmarkFamily4x4::isCorner(x, y)) {
+        id |= LandmarkFamily4x4::getBit(x, y);
+        id_points--;
+      }
+    }
+  }
+  return id;
+}
+
+/**
+ * @brief Pixel positions of the LEDs of a landmark, whose first corner lies at origin
+ */
+std::vector<cv::Point> landmarkPixels(landmark_id_t id, const cv::Point& origin) {
+  std::vector<cv::Point> pixels;
+  for (const Point& pt : getLandmarkPoints(id)) {
+    pixels.emplace_back(origin.x + cvRound(pt[(int)POINT::Y] / kLandmarkGridDistance * kLedSpacing),
+                        origin.y + cvRound(pt[(int)POINT::X] / kLandmarkGridDistance * kLedSpacing));
+  }
+  return pixels;
+}
+
+/**
+ * @brief Points of a synthetic scene, ordered like a raster scan would find them
+ *
+ * @param ids IDs of the landmarks, laid out row by row
+ * @param noise_blobs Number of spots at random positions
+ * @return std::vector<cv::Point> Empty, if the landmarks do not fit into the image
+ */
+std::vector<cv::Point> scenePoints(const cv::Size& size, const std::vector<landmark_id_t>& ids, int noise_blobs) {
+  const int cols = (size.width - kLandmarkSpacing / 2) / kLandmarkSpacing;
+  const int rows = (size.height - kLandmarkSpacing / 2) / kLandmarkSpacing;
+  std::vector<cv::Point> points;
+  if (static_cast<int>(ids.size()) > cols * rows) {
+    return points;
+  }
+  for (size_t i = 0; i < ids.size(); i++) {
+    const cv::Point origin(kLandmarkSpacing / 2 + static_cast<int>(i % cols) * kLandmarkSpacing,
+                           kLandmarkSpacing / 2 + static_cast<int>(i / cols) * kLandmarkSpacing);
+    for (const cv::Point& pixel : landmarkPixels(ids[i], origin)) {
+      points.push_back(pixel);
+    }
+  }
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> x(kLedRadius, size.width - 1 - kLedRadius);
+  std::uniform_int_distribution<int> y(kLedRadius, size.height - 1 - kLedRadius);
+  for (int i = 0; i < noise_blobs; i++) {
+    points.emplace_back(x(rng), y(rng));
+  }
+  std::sort(points.begin(), points.end(), [](const cv::Point& lhs, const cv::Point& rhs) {
+    return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+  });
+  return points;
+}
+
+/**
+ * @brief IDs of the test map, repeated until count landmarks are reached
+ */
+std::vector<landmark_id_t> mapIds(int count) {
+  std::vector<landmark_id_t> map_ids;
+  for (auto& el : testMap()->getWorldLandmarks()) {
+    map_ids.push_back(el.first);
+  }
+  std::vector<landmark_id_t> ids;
+  for (int i = 0; i < count; i++) {
+    ids.push_back(map_ids[i % map_ids.size()]);
+  }
+  return ids;
+}
+
+/**
+ * @brief Renders points as bright spots on a black grayvalue image
+ */
+cv::Mat renderScene(const cv::Size& size, const std::vector<cv::Point>& points) {
+  cv::Mat img(size, CV_8UC1, cv::Scalar(0));
+  for (const cv::Point& pt : points) {
+    cv::circle(img, pt, kLedRadius, cv::Scalar(255), -1);
+  }
+  return img;
+}
+
+cv::Size imageSize(const benchmark::State& state) {
+  return cv::Size(static_cast<int>(state.range(0)), static_cast<int>(state.range(0)) * 3 / 4);
+}
+
+/// Arguments: image width, landmark count, noise blob count
+void sceneArguments(benchmark::internal::Benchmark* b) {
+  for (int width : {640, 1280, 1920}) {
+    for (int landmarks : {1, 8, 32}) {
+      for (int noise : {0, 50}) {
+        b->Args({width, landmarks, noise});
+      }
+    }
+  }
+}
+
+}  // namespace
+
+static void BM_FindBlobs(benchmark::State& state) {
+  const cv::Size size = imageSize(state);
+  const std::vector<cv::Point> points =
+      scenePoints(size, mapIds(static_cast<int>(state.range(1))), static_cast<int>(state.range(2)));
+  if (points.empty()) {
+    state.SkipWithError("Landmarks do not fit into image");
+    return;
+  }
+  LandmarkFinder finder(testMap());
+  LandmarkFinderStages stages(finder);
+  LandmarkFinder::Workspace workspace;
+  workspace.grayImage = renderScene(size, points);
+
+  for (auto _ : state) {
+    workspace.arena.Reset();
+    LandmarkFinderStages::ScratchPoints blobs(workspace.arena.getResource());
+    stages.FindBlobs(workspace, blobs);
+    benchmark::DoNotOptimize(blobs.data());
+  }
+  state.counters["pixels"] =
+      benchmark::Counter(static_cast<double>(size.area()), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_FindBlobs)->Apply(sceneArguments)->Unit(benchmark::kMillisecond);
+
+/// Arguments: landmark count, points per cluster, noise blob count
+static void BM_FindClusters(benchmark::State& state) {
+  const int landmarks = static_cast<int>(state.range(0));
+  const std::vector<landmark_id_t> ids(landmarks, syntheticId(static_cast<int>(state.range(1)) - 3));
+  const cv::Size size(1920, 1440);
+  const std::vector<cv::Point> points = scenePoints(size, ids, static_cast<int>(state.range(2)));
+  LandmarkFinder finder(testMap());
+  LandmarkFinderStages stages(finder);
+  FrameArena arena;
+
+  for (auto _ : state) {
+    arena.Reset();
+    LandmarkFinderStages::ScratchPoints input(points.begin(), points.end(), arena.getResource());
+    LandmarkFinderStages::ScratchClusters clusters(arena.getResource());
+    stages.FindClusters(input, clusters, 3 + ImgLandmark::kMaxIdPoints);
+    benchmark::DoNotOptimize(clusters.offsets.data());
+  }
+  state.counters["points"] =
+      benchmark::Counter(static_cast<double>(points.size()), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_FindClusters)
+    ->ArgsProduct({{1, 32, 200}, {5, 9, 15}, {0, 50}})
+    ->Unit(benchmark::kMicrosecond);
+
+/// Arguments: points per cluster
+static void BM_FindCorners(benchmark::State& state) {
+  const std::vector<cv::Point> points = landmarkPixels(syntheticId(static_cast<int>(state.range(0)) - 3), {0, 0});
+  LandmarkFinder finder(testMap());
+  LandmarkFinderStages stages(finder);
+  FrameArena arena;
+  std::vector<ImgLandmark> hypotheses;
+
+  for (auto _ : state) {
+    arena.Reset();
+    LandmarkFinderStages::ScratchClusters clusters(arena.getResource());
+    clusters.points.assign(points.begin(), points.end());
+    clusters.offsets.push_back(static_cast<uint32_t>(points.size()));
+    hypotheses.clear();
+    stages.FindCorners(clusters, arena.getResource(), hypotheses);
+    benchmark::DoNotOptimize(hypotheses.data());
+  }
+}
+BENCHMARK(BM_FindCorners)->DenseRange(5, 15, 2)->Unit(benchmark::kMicrosecond);
+
+/// Arguments: landmark count. Every iteration decodes a fresh copy of the hypotheses.
+static void BM_GetIDs(benchmark::State& state) {
+  const cv::Size size(1920, 1440);
+  const std::vector<cv::Point> points = scenePoints(size, mapIds(static_cast<int>(state.range(0))), 0);
+  LandmarkFinder finder(testMap());
+  LandmarkFinderStages stages(finder);
+  LandmarkFinder::Workspace workspace;
+  workspace.map = testMap();
+  workspace.grayImage = renderScene(size, points);
+
+  // The hypotheses are built in their own arena, the workspace arena is reset every iteration
+  FrameArena setup_arena;
+  LandmarkFinderStages::ScratchPoints input(points.begin(), points.end(), setup_arena.getResource());
+  LandmarkFinderStages::ScratchClusters clusters(setup_arena.getResource());
+  stages.FindClusters(
+      input, clusters, testMap()->getMaxPointCount() + finder.extraPointsPerLandmark);
+  std::vector<ImgLandmark> hypotheses;
+  stages.FindCorners(clusters, setup_arena.getResource(), hypotheses);
+
+  std::vector<ImgLandmark> landmarks;
+  for (auto _ : state) {
+    workspace.arena.Reset();
+    landmarks = hypotheses;
+    stages.GetIDs(landmarks, workspace);
+    benchmark::DoNotOptimize(landmarks.data());
+  }
+  state.counters["hypotheses"] = static_cast<double>(hypotheses.size());
+  state.counters["landmarks"] = static_cast<double>(landmarks.size());
+}
+BENCHMARK(BM_GetIDs)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMicrosecond);
+
+static void BM_DetectLandmarks(benchmark::State& state) {
+  const cv::Size size = imageSize(state);
+  const std::vector<cv::Point> points =
+      scenePoints(size, mapIds(static_cast<int>(state.range(1))), static_cast<int>(state.range(2)));
+  if (points.empty()) {
+    state.SkipWithError("Landmarks do not fit into image");
+    return;
+  }
+  const cv::Mat img = renderScene(size, points);
+  LandmarkFinder finder(testMap());
+  LandmarkFinder::Workspace workspace;
+  std::vector<ImgLandmark> landmarks;
+
+  for (auto _ : state) {
+    finder.DetectLandmarks(img, landmarks, workspace);
+    benchmark::DoNotOptimize(landmarks.data());
+  }
+  state.counters["landmarks"] = static_cast<double>(landmarks.size());
+  state.counters["fps"] = benchmark::Counter(1., benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_DetectLandmarks)->Apply(sceneArguments)->Unit(benchmark::kMillisecond);
+
+static void BM_DetectLandmarksFrame(benchmark::State& state) {
+  const cv::Mat img = cv::imread(kResDir + "/frame0135.jpg", cv::IMREAD_GRAYSCALE);
+  if (img.empty()) {
+    state.SkipWithError("Could not read res/frame0135.jpg");
+    return;
+  }
+  LandmarkFinder finder(testMap());
+  LandmarkFinder::Workspace workspace;
+  std::vector<ImgLandmark> landmarks;
+
+  for (auto _ : state) {
+    finder.DetectLandmarks(img, landmarks, workspace);
+    benchmark::DoNotOptimize(landmarks.data());
+  }
+  state.counters["landmarks"] = static_cast<double>(landmarks.size());
+  state.counters["fps"] = benchmark::Counter(1., benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_DetectLandmarksFrame)->Unit(benchmark::kMillisecond);
+
+/// Arguments: landmark count, at most the number of landmarks detected in res/frame0135.jpg
+static void BM_UpdatePose(benchmark::State& state) {
+  const cv::Mat img = cv::imread(kResDir + "/frame0135.jpg", cv::IMREAD_GRAYSCALE);
+  LandmarkFinder finder(testMap());
+  std::vector<ImgLandmark> detected;
+  finder.DetectLandmarks(img, detected);
+  if (detected.size() < static_cast<size_t>(state.range(0))) {
+    state.SkipWithError("Not enough landmarks detected in res/frame0135.jpg");
+    return;
+  }
+  detected.resize(static_cast<size_t>(state.range(0)));
+  CeresLocalizer localizer(kResDir + "/cam.yaml", testMap());
+  std::vector<ImgLandmark> landmarks;
+
+  for (auto _ : state) {
+    landmarks = detected;  // UpdatePose may modify its input
+    localizer.UpdatePose(landmarks, 0.f);
+    benchmark::DoNotOptimize(localizer.getPose().data());
+  }
+  state.counters["iterations"] = static_cast<double>(localizer.getSummary().iterations.size());
+}
+BENCHMARK(BM_UpdatePose)->DenseRange(1, 8)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
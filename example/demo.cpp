@@ -6,8 +6,8 @@ using namespace stargazer;
 using namespace std;
 
 int main(int argc, char** argv) {
-  if (argc != 3) {
-    cout << " Usage: " << argv[0] << " <image_file> <config_file>" << endl;
+  if (argc != 4) {
+    cout << " Usage: " << argv[0] << " <image_file> <cam_config_file> <map_config_file>" << endl;
     return -1;
   }
   cv::Mat input_image = cv::imread(argv[1], CV_LOAD_IMAGE_COLOR);  // Read the file
@@ -16,33 +16,38 @@ int main(int argc, char** argv) {
   debugVisualizer.SetWaitTime(-1);  // Wait until user has pressed key
   debugVisualizer.SetWindowMode(CV_WINDOW_NORMAL);
 
-  LandmarkFinder landmarkFinder(argv[2]);
+  // The map is loaded once and shared between finder and localizer
+  LandmarkMap::ConstPtr map = std::make_shared<const LandmarkMap>(argv[3]);
+
+  LandmarkFinder landmarkFinder(map);
+  LandmarkFinder::DebugSink debug;
+  LandmarkFinder::Workspace workspace;
+  workspace.debugSink = &debug;  // Keep intermediate results for visualization
   std::vector<ImgLandmark> detected_landmarks;
-  landmarkFinder.DetectLandmarks(input_image, detected_landmarks);
+  landmarkFinder.DetectLandmarks(input_image, detected_landmarks, workspace);
 
   cout << "Displaying images, press any key to continue.... " << endl;
 
   // Invert images for better visibilty
-  cv::bitwise_not(landmarkFinder.grayImage_, landmarkFinder.grayImage_);
-  debugVisualizer.ShowImage(landmarkFinder.grayImage_, "0 Gray Image");
+  cv::bitwise_not(debug.grayImage, debug.grayImage);
+  debugVisualizer.ShowImage(debug.grayImage, "0 Gray Image");
 
   // Draw detections
   debugVisualizer.ShowImage(
-      debugVisualizer.DrawPoints(landmarkFinder.grayImage_, landmarkFinder.points_),
+      debugVisualizer.DrawPoints(debug.grayImage, debug.points),
       "1 Points");
   debugVisualizer.ShowImage(
-      debugVisualizer.DrawClusters(landmarkFinder.grayImage_, landmarkFinder.clusteredPoints_),
+      debugVisualizer.DrawClusters(debug.grayImage, debug.clusteredPoints),
       "2 Clusters");
   debugVisualizer.ShowImage(debugVisualizer.DrawLandmarkHypotheses(
-                                landmarkFinder.grayImage_, landmarkFinder.landmarkHypotheses_),
+                                debug.grayImage, debug.landmarkHypotheses),
                             "3 Hypotheses");
   debugVisualizer.ShowImage(
-      debugVisualizer.DrawLandmarks(landmarkFinder.grayImage_, detected_landmarks),
+      debugVisualizer.DrawLandmarks(debug.grayImage, detected_landmarks),
       "4 Landmarks");
 
   // Localize
-  const std::string args(argv[2]);
-  CeresLocalizer localizer(args);
+  CeresLocalizer localizer(argv[2], map);
   localizer.UpdatePose(detected_landmarks, 0.0);
   cout << localizer.getSummary().FullReport() << endl << endl;
 
@@ -0,0 +1,151 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "LandmarkFinder.h"
+#include "Localizer.h"
+#include "StargazerImgTypes.h"
+#include "StargazerTypes.h"
+#include "internal/WorkStealingPool.h"
+
+namespace stargazer {
+
+/**
+ * @brief Result of an asynchronous pose update
+ */
+struct PoseResult {
+  pose_t pose = {{0., 0., 0., 0., 0., 0.}}; /**< Camera pose */
+  pose_covariance_t covariance = {};       /**< Covariance of the pose, if has_covariance */
+  bool has_covariance = false;             /**< Whether the localizer provided a covariance */
+  size_t landmark_count = 0;               /**< Number of landmarks the pose is based on */
+  double detection_time = 0.;              /**< Duration of the landmark detection in seconds */
+  double solve_time = 0.;                  /**< Duration of the pose update in seconds */
+};
+
+/**
+ * @brief Runs a Localizer (and optionally a LandmarkFinder) on an internal executor thread, so
+ * that the caller is not blocked for the whole solve. Requests are processed one after the other,
+ * in the order they were made. Results are delivered by future or callback.
+ */
+class AsyncLocalizer {
+ public:
+  /**
+   * @brief Receives the result of a request on the executor thread. If the request failed, error
+   * holds the exception and result is empty. Exceptions thrown by the callback are logged and
+   * dropped.
+   */
+  typedef std::function<void(const PoseResult& result, std::exception_ptr error)> Callback;
+
+  /**
+   * @brief Constructor. Starts the executor thread.
+   *
+   * @param localizer Localizer, it is used by the executor exclusively
+   * @param finder Optional finder for requests with images, it is used by the executor exclusively
+   * @param compute_covariance Whether to compute the pose covariance after every update
+   */
+  AsyncLocalizer(std::unique_ptr<Localizer> localizer,
+                 std::unique_ptr<LandmarkFinder> finder = nullptr,
+                 bool compute_covariance = true);
+
+  /**
+   * @brief Destructor. Waits for the running request, queued requests are discarded: their
+   * callbacks are never called and their futures fail with std::future_error (broken_promise).
+   */
+  ~AsyncLocalizer();
+
+  AsyncLocalizer(const AsyncLocalizer&) = delete;
+  AsyncLocalizer& operator=(const AsyncLocalizer&) = delete;
+
+  /**
+   * @brief Requests a pose update from landmark observations.
+   *
+   * @param img_landmarks Observed landmarks
+   * @param dt Time since last update
+   * @return std::future<PoseResult>
+   */
+  std::future<PoseResult> UpdatePose(std::vector<ImgLandmark> img_landmarks, float dt);
+
+  /**
+   * @brief Requests a pose update from landmark observations.
+   *
+   * @param img_landmarks Observed landmarks
+   * @param dt Time since last update
+   * @param callback Receiver of the result
+   */
+  void UpdatePose(std::vector<ImgLandmark> img_landmarks, float dt, Callback callback);
+
+  /**
+   * @brief Requests landmark detection and pose update for an image.
+   *
+   * @param img Camera image, it must not be modified until the request is done
+   * @param dt Time since last update
+   * @return std::future<PoseResult>
+   * @throws std::runtime_error if no finder has been given
+   */
+  std::future<PoseResult> Localize(const cv::Mat& img, float dt);
+
+  /**
+   * @brief Requests landmark detection and pose update for an image.
+   *
+   * @param img Camera image, it must not be modified until the request is done
+   * @param dt Time since last update
+   * @param callback Receiver of the result
+   * @throws std::runtime_error if no finder has been given
+   */
+  void Localize(const cv::Mat& img, float dt, Callback callback);
+
+  /**
+   * @brief Getter for the result of the last finished request. Safe to call from any thread.
+   *
+   * @return PoseResult
+   */
+  PoseResult getLastResult() const;
+
+ private:
+  std::unique_ptr<Localizer> localizer_;   /**< Used by the executor only */
+  std::unique_ptr<LandmarkFinder> finder_; /**< Used by the executor only */
+  bool compute_covariance_;                /**< Whether to compute the pose covariance */
+  mutable std::mutex result_mutex_;        /**< Guards last_result_ */
+  PoseResult last_result_;                 /**< Result of the last finished request */
+  WorkStealingPool executor_{1}; /**< Single worker, declared last to stop it first */
+
+  /**
+   * @brief Detects the landmarks, if an image is given, and updates the pose. Runs on the executor.
+   */
+  PoseResult Run(const cv::Mat* img, std::vector<ImgLandmark>& img_landmarks, float dt);
+
+  /**
+   * @brief Queues a request, which reports to the callback
+   */
+  void Submit(std::function<PoseResult()> request, Callback callback);
+
+  /**
+   * @brief Queues a request, which reports to a future
+   */
+  std::future<PoseResult> Submit(std::function<PoseResult()> request);
+};
+
+}  // namespace stargazer
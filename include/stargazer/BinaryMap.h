@@ -0,0 +1,184 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "StargazerTypes.h"
+
+namespace stargazer {
+
+/*  Layout of a binary map file (all values in host byte order)
+ *
+ *  +-------------------------------+  0
+ *  | BinaryMapHeader               |
+ *  +-------------------------------+  header.landmarks_offset
+ *  | BinaryMapLandmark[n_landmarks]|  sorted by ascending id
+ *  +-------------------------------+  header.points_offset
+ *  | Point[n_points]               |  world coordinates
+ *  +-------------------------------+
+ *
+ * Every landmark references a contiguous range of world points. The first
+ * three points of a range are the corners, just like in Landmark::points.
+ */
+
+constexpr char kBinaryMapMagic[8] = {'S', 'G', 'Z', 'M', 'A', 'P', '\0', '\0'}; /**< File signature */
+constexpr uint32_t kBinaryMapVersion = 2; /**< Current version of the binary map layout */
+
+/**
+ * @brief File header of a binary map.
+ */
+struct BinaryMapHeader {
+  char magic[8];             /**< Has to match ::kBinaryMapMagic */
+  uint32_t version;          /**< Layout version, see ::kBinaryMapVersion */
+  uint32_t landmark_count;   /**< Number of landmark records */
+  uint64_t point_count;      /**< Number of world points */
+  uint64_t landmarks_offset; /**< Byte offset of the first landmark record */
+  uint64_t points_offset;    /**< Byte offset of the first world point */
+  uint32_t family;           /**< Layout of all landmarks, see ::LANDMARK_FAMILY */
+  uint32_t reserved;         /**< Padding, zero */
+};
+
+/**
+ * @brief Landmark record of a binary map.
+ */
+struct BinaryMapLandmark {
+  uint32_t id;          /**< The landmarks id */
+  uint32_t point_count; /**< Number of points of this landmark */
+  uint64_t first_point; /**< Index of the first world point of this landmark */
+  double pose[(int)POSE::N_PARAMS]; /**< The landmarks pose */
+};
+
+static_assert(sizeof(Point) == 3 * sizeof(double), "Point has to be densely packed");
+
+/**
+ * @brief Read-only view onto a binary map file. The file gets memory mapped on
+ * construction, so no parsing or allocation takes place when accessing landmarks.
+ *
+ * @remark The file has to be generated with ::writeBinaryMap or ::convertMapConfigToBinary!
+ */
+class BinaryMap {
+ public:
+  /**
+   * @brief Constructor. Maps the file into memory and validates its header.
+   *
+   * @param mapfile Path to binary map file
+   * @throws std::runtime_error if the file can not be mapped or is no valid binary map, e.g. if a
+   * section or the point range of a landmark exceeds the file
+   */
+  explicit BinaryMap(const std::string& mapfile);
+
+  /**
+   * @brief Destructor. Unmaps the file.
+   */
+  ~BinaryMap();
+
+  BinaryMap(const BinaryMap&) = delete;
+  BinaryMap& operator=(const BinaryMap&) = delete;
+
+  /**
+   * @brief Number of landmarks in this map
+   */
+  size_t size() const { return header_->landmark_count; }
+
+  /**
+   * @brief Getter for the layout of all landmarks in this map
+   */
+  LANDMARK_FAMILY getFamily() const { return static_cast<LANDMARK_FAMILY>(header_->family); }
+
+  /**
+   * @brief Iterators over all landmark records, sorted by ascending id
+   */
+  const BinaryMapLandmark* begin() const { return landmarks_; }
+  const BinaryMapLandmark* end() const { return landmarks_ + size(); }
+
+  /**
+   * @brief Looks up a landmark record by id (binary search)
+   *
+   * @param id Landmark ID
+   * @return const BinaryMapLandmark* Record or nullptr if id is not part of the map
+   */
+  const BinaryMapLandmark* find(landmark_id_t id) const;
+
+  /**
+   * @brief Getter for the world points of a landmark record
+   *
+   * @param lm Landmark record of this map
+   * @return const Point* Pointer to the first of lm.point_count world points
+   */
+  const Point* getWorldPoints(const BinaryMapLandmark& lm) const { return points_ + lm.first_point; }
+
+  /**
+   * @brief Converts the view into a map of landmarks. Points are given in landmark coordinates,
+   * just like after ::readMapConfig, and generated for the family of the map.
+   *
+   * @param landmarks Output map
+   */
+  void toLandmarkMap(landmark_map_t& landmarks) const;
+
+ private:
+  void* data_ = nullptr; /**< Start of mapped memory */
+  size_t length_ = 0;    /**< Length of mapped memory */
+  const BinaryMapHeader* header_ = nullptr;
+  const BinaryMapLandmark* landmarks_ = nullptr;
+  const Point* points_ = nullptr;
+};
+
+/**
+ * @brief Writes a binary map. World points are precomputed from the landmark poses.
+ *
+ * @param mapfile Path of the binary map file
+ * @param landmarks Map of landmarks. Points have to be defined in landmark coordinates!
+ * @param family Layout of the landmarks, it is stored in the file
+ */
+void writeBinaryMap(const std::string& mapfile,
+                    const landmark_map_t& landmarks,
+                    LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4);
+
+/**
+ * @brief Reads a binary map into a map of landmarks (in landmark coordinates). The points are
+ * generated for the family stored in the file.
+ *
+ * @param mapfile Path of the binary map file
+ * @param landmarks Output map
+ */
+void readBinaryMap(const std::string& mapfile, landmark_map_t& landmarks);
+
+/**
+ * @brief Converts a yaml map config (see ::writeMapConfig) into a binary map.
+ *
+ * @param cfgfile Path of the yaml map config
+ * @param mapfile Path of the binary map file to write
+ * @param family Layout of the landmarks, it is stored in the binary map
+ */
+void convertMapConfigToBinary(const std::string& cfgfile,
+                              const std::string& mapfile,
+                              LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4);
+
+/**
+ * @brief Converts a binary map into a yaml map config (see ::writeMapConfig).
+ *
+ * @param mapfile Path of the binary map file
+ * @param cfgfile Path of the yaml map config to write
+ */
+void convertBinaryToMapConfig(const std::string& mapfile, const std::string& cfgfile);
+
+}  // namespace stargazer
@@ -43,12 +43,34 @@ class CeresLocalizer : public Localizer {
    * @param cfgfile Path to map file with camera intrinsics and landmark poses.
    * @param estimae_2d_pose whether the whole 3d pose shall be estimatet or just the 2d pose.
    * @remark The config file has to be generated with ::writeConfig!
-   * @remark The CeresLocalizer converts all landmark points into world coordinates after readin!
+   * @remark The CeresLocalizer uses the landmark points in world coordinates, precomputed by LandmarkMap!
    */
   CeresLocalizer(const std::string& cam_cfgfile,
                  const std::string& map_cfgfile,
                  bool estimate_2d_pose = false);
 
+  /**
+   * @brief Constructor.
+   *
+   * @param cam_cfgfile Path to config file with camera intrinsics.
+   * @param map Shared map with landmark poses.
+   * @param estimae_2d_pose whether the whole 3d pose shall be estimatet or just the 2d pose.
+   */
+  CeresLocalizer(const std::string& cam_cfgfile,
+                 LandmarkMap::ConstPtr map,
+                 bool estimate_2d_pose = false);
+
+  /**
+   * @brief Constructor.
+   *
+   * @param cam_cfgfile Path to config file with camera intrinsics.
+   * @param map_handle Handle to the shared map. Published maps are used from the next update on.
+   * @param estimae_2d_pose whether the whole 3d pose shall be estimatet or just the 2d pose.
+   */
+  CeresLocalizer(const std::string& cam_cfgfile,
+                 LandmarkMapHandle::Ptr map_handle,
+                 bool estimate_2d_pose = false);
+
   /**
    * @brief Main update method. Computes pose from landmark observations and stores it in Localizer::ego_pose
    *
@@ -56,6 +78,7 @@ class CeresLocalizer : public Localizer {
    * @param dt Time since last update (unused in this implementation)
    */
   virtual void UpdatePose(std::vector<ImgLandmark>& img_landmarks, float dt) override;
+  using Localizer::UpdatePose;
 
   /**
    * @brief Returns the full summary of the ceres optimization process. It
@@ -65,12 +88,23 @@ class CeresLocalizer : public Localizer {
    */
   const ceres::Solver::Summary& getSummary() const { return summary; }
 
+  /**
+   * @brief Computes the covariance of the pose from the last call to CeresLocalizer::UpdatePose.
+   *
+   * @param covariance Output covariance
+   * @return bool False, if the last update did not optimize the pose (e.g. no landmarks) or the
+   * problem is rank deficient
+   */
+  virtual bool ComputePoseCovariance(pose_covariance_t& covariance) override;
+
  private:
   ceres::Problem problem;         /**< Ceres Prolem */
   ceres::Solver::Summary summary; /**< Summary of last optimization run */
 
   bool is_initialized; /**< Flag indicating whether the pose is initialized */
 
+  bool is_solved = false; /**< Whether the last update optimized the pose, see ComputePoseCovariance */
+
   bool estimate_2d_pose = false;
 
   double z_upper_bound;
@@ -86,7 +120,7 @@ class CeresLocalizer : public Localizer {
    *
    * @param img_landmarks Vector of observerved landmarks.
    */
-  void AddResidualBlocks(std::vector<ImgLandmark> img_landmarks);
+  void AddResidualBlocks(const std::vector<ImgLandmark>& img_landmarks);
 
   /**
    * @brief Will set the camera parameters constant, so that they do not get changed during optimization.
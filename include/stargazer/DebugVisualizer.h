@@ -20,6 +20,7 @@
 
 #include <opencv2/highgui/highgui.hpp>
 
+#include "LandmarkMap.h"
 #include "StargazerImgTypes.h"
 #include "StargazerTypes.h"
 
@@ -121,6 +122,20 @@ class DebugVisualizer {
                         const camera_params_t& camera_intrinsics,
                         const pose_t& ego_pose);
 
+  /**
+   * @brief Draws the landmarks of a map, which are visible from the given camera pose, into the img
+   *
+   * @param img   Input image, gets modified!
+   * @param map Map of Landmarks. Only landmarks in the cameras field of view get projected.
+   * @param camera_intrinsics Camera parameters
+   * @param ego_pose  Camera pose
+   * @return cv::Mat A copy of the input image with the drawn landmarks
+   */
+  cv::Mat DrawLandmarks(const cv::Mat& img,
+                        const LandmarkMap& map,
+                        const camera_params_t& camera_intrinsics,
+                        const pose_t& ego_pose);
+
  private:
   static const cv::Scalar FZI_BLUE, FZI_GREEN, FZI_RED;
   static const int TEXT_OFFSET, POINT_THICKNESS, POINT_RADIUS_IMG, POINT_RADIUS_MAP;
@@ -136,6 +151,19 @@ class DebugVisualizer {
    */
   void prepareImg(cv::Mat& img);
 
+  /**
+   * @brief Draws a single landmark given in world coordinates into img
+   *
+   * @param img Image to draw into
+   * @param landmark Landmark in world coordinates
+   * @param camera_intrinsics Camera parameters
+   * @param ego_pose  Camera pose
+   */
+  void drawMapLandmark(cv::Mat& img,
+                       const Landmark& landmark,
+                       const camera_params_t& camera_intrinsics,
+                       const pose_t& ego_pose);
+
   /**
    * @brief Converts point in world coordinates into image coordinates
    *
@@ -24,6 +24,7 @@
 #include <ceres/ceres.h>
 
 #include "CoordinateTransformations.h"
+#include "LandmarkMap.h"
 #include "StargazerImgTypes.h"
 
 namespace stargazer {
@@ -44,6 +45,15 @@ class LandmarkCalibrator {
    */
   LandmarkCalibrator(const std::string& cam_cfgfile, const std::string& map_cfgfile);
 
+  /**
+   * @brief Constructor.
+   *
+   * @param cam_cfgfile Path to file with camera intrinsics.
+   * @param map Shared map with initial landmark poses. The landmarks get copied, as they are
+   * modified during optimization.
+   */
+  LandmarkCalibrator(const std::string& cam_cfgfile, const LandmarkMap::ConstPtr& map);
+
   /**
    * @brief Adds all residual blocks to the problem. For every marker of every
    * seen landmark at every pose a residual block is added to the problem.
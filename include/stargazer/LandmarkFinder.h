@@ -18,21 +18,77 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
 #include <vector>
 
 #include <opencv2/features2d.hpp>
 
-#include "StargazerConfig.h"
+#include "LandmarkMap.h"
 #include "StargazerImgTypes.h"
+#include "StargazerStats.h"
 #include "StargazerTypes.h"
+#include "VisibilityTable.h"
+#include "internal/FrameArena.h"
 
 namespace stargazer {
 
 /**
  * @brief This class detects landmarks in images.
+ *
+ * @remark The const LandmarkFinder::DetectLandmarks keeps all per-frame state in a
+ * LandmarkFinder::Workspace, so one finder can serve several cameras or threads, each with its
+ * own workspace. Parameters must not be changed while detections are running.
  */
 class LandmarkFinder {
  public:
+  /**
+   * @brief Receives copies of the intermediate results of LandmarkFinder::DetectLandmarks, e.g.
+   * for the DebugVisualizer. Only filled, if it is set at the workspace.
+   */
+  struct DebugSink {
+    cv::Mat grayImage;             /**< Grayvalue image */
+    std::vector<cv::Point> points; /**< Points found */
+    std::vector<Cluster> clusteredPoints;        /**< Point clusters found */
+    std::vector<ImgLandmark> landmarkHypotheses; /**< Landmark hypotheses before ID decoding */
+  };
+
+  /**
+   * @brief Per-call state of LandmarkFinder::DetectLandmarks. A workspace belongs to a single
+   * finder and must not be used by two detections at the same time. Reusing it for consecutive
+   * frames avoids reallocations: the scratch data of a frame is taken from its arena, which is
+   * reset at the start of every call.
+   */
+  struct Workspace {
+    cv::Mat grayImage;                   /**< Scratch: grayvalue image */
+    std::vector<cv::KeyPoint> keypoints; /**< Scratch: blobs found, keeps its capacity */
+    FrameArena arena;                    /**< Scratch memory of the current frame */
+    DebugSink* debugSink = nullptr; /**< Optional receiver of intermediate results (not owned) */
+    DetectionStats* stats = nullptr; /**< Optional receiver of stage timings and counts (not owned) */
+
+    LandmarkMap::ConstPtr map;      /**< Map snapshot, taken at the start of every frame */
+    uint64_t mapGeneration = 0;     /**< Generation of the snapshot */
+    Point positionHint = {{0., 0., 0.}}; /**< Approximate camera position */
+    bool hasPositionHint = false;        /**< Whether positionHint is set */
+
+    /**
+     * @brief Sets the approximate camera position, e.g. the last pose computed by the Localizer.
+     *
+     * @param x x coordinate of camera in world coordinates
+     * @param y y coordinate of camera in world coordinates
+     */
+    void SetPositionHint(double x, double y) {
+      positionHint = {{x, y, 0.}};
+      hasPositionHint = true;
+    }
+
+    /**
+     * @brief Removes the position hint, all IDs of the map are accepted again.
+     */
+    void ClearPositionHint() { hasPositionHint = false; }
+  };
+
   /**
    * @brief Constructor.
    *
@@ -41,26 +97,126 @@ class LandmarkFinder {
    */
   LandmarkFinder(std::string cfgfile);
 
+  /**
+   * @brief Constructor.
+   *
+   * @param map Shared map, the valid landmark IDs are taken from.
+   */
+  LandmarkFinder(LandmarkMap::ConstPtr map);
+
+  /**
+   * @brief Constructor.
+   *
+   * @param map_handle Handle to the shared map. Maps published to it are used from the next
+   * call to LandmarkFinder::DetectLandmarks on.
+   */
+  LandmarkFinder(LandmarkMapHandle::Ptr map_handle);
+
   /**
    * @brief Destructor
    */
   ~LandmarkFinder();
 
   /**
-   * @brief Main worker function. Writes all detected landmarks into vector
+   * @brief Main worker function. Writes all detected landmarks into vector. Thread-safe, as long
+   * as every caller passes its own workspace.
    *
    * @param img Image to analyze
    * @param detected_landmarks Output vector of detected landmarks
+   * @param workspace Per-call state, holds the intermediate results afterwards
    * @return int Error code
    */
-  int DetectLandmarks(const cv::Mat& img, std::vector<ImgLandmark>& detected_landmarks);
+  int DetectLandmarks(const cv::Mat& img,
+                      std::vector<ImgLandmark>& detected_landmarks,
+                      Workspace& workspace) const;
+
+  /**
+   * @brief Detects the landmarks of many frames in parallel, e.g. to reprocess a log. Every
+   * thread uses its own workspace, without position hint.
+   *
+   * @remark Threads and workspaces are created anew on every call, so unlike DetectLandmarks with
+   * a reused workspace, this is not free of allocations. Live streams should use
+   * LocalizationService, which keeps a workspace per stream and a thread pool.
+   *
+   * @param images Images to analyze
+   * @param detected_landmarks Output, detected landmarks of every image in input order
+   * @param thread_count Maximum number of threads
+   * @return int Error code, -1 if at least one image was invalid (its landmarks stay empty)
+   */
+  int DetectLandmarksBatch(const std::vector<cv::Mat>& images,
+                           std::vector<std::vector<ImgLandmark>>& detected_landmarks,
+                           size_t thread_count = std::thread::hardware_concurrency()) const;
+
+  /**
+   * @brief Main worker function, using the workspace of this finder. Not thread-safe.
+   *
+   * @param img Image to analyze
+   * @param detected_landmarks Output vector of detected landmarks
+   * @return int Error code
+   */
+  int DetectLandmarks(const cv::Mat& img, std::vector<ImgLandmark>& detected_landmarks) {
+    return DetectLandmarks(img, detected_landmarks, workspace_);
+  }
+
+  /**
+   * @brief Getter for the workspace of this finder, used by LandmarkFinder::DetectLandmarks
+   * without workspace
+   *
+   * @return const Workspace&
+   */
+  const Workspace& getWorkspace() const { return workspace_; }
+
+  /**
+   * @brief Sets a debug sink at the own workspace, see Workspace::debugSink.
+   *
+   * @param sink Receiver of intermediate results, has to outlive the finder (nullptr to disable)
+   */
+  void SetDebugSink(DebugSink* sink) { workspace_.debugSink = sink; }
+
+  /**
+   * @brief Sets a stats struct at the own workspace, see Workspace::stats.
+   *
+   * @param stats Receiver of the stats of every frame, has to outlive the finder (nullptr to disable)
+   */
+  void SetStats(DetectionStats* stats) { workspace_.stats = stats; }
+
+  /**
+   * @brief Getter for the map snapshot of the own workspace, the valid landmark IDs are taken from
+   *
+   * @return const LandmarkMap::ConstPtr&
+   */
+  const LandmarkMap::ConstPtr& getMap() const { return workspace_.map; }
+
+  /**
+   * @brief Getter for the handle, new maps can be published to
+   *
+   * @return const LandmarkMapHandle::Ptr&
+   */
+  const LandmarkMapHandle::Ptr& getMapHandle() const { return map_handle_; }
 
-  cv::Mat grayImage_;             /**< Keeps a copy of the grayvalue image */
-  std::vector<cv::Point> points_; /**< Keeps a copy of points found */
-  std::vector<Cluster> clusteredPoints_; /**< Keeps a copy of point clusters found*/
-  std::vector<ImgLandmark> landmarkHypotheses_; /**< Keeps a copy of landmark hypotheses*/
+  /**
+   * @brief Sets a precompiled visibility table. As long as a position hint within the table's area
+   * is set, decoded IDs are only accepted if they are visible from the hinted position. The table
+   * is ignored while the current map differs from the one it has been compiled for.
+   *
+   * @param table Visibility table compiled for the map and camera in use (nullptr to disable)
+   */
+  void SetVisibilityTable(VisibilityTable::ConstPtr table) { visibility_table_ = std::move(table); }
 
-  std::vector<uint16_t> valid_ids_; /**< Vector of valid IDs, read from map*/
+  /**
+   * @brief Sets the approximate camera position of the own workspace, see
+   * Workspace::SetPositionHint.
+   *
+   * @param x x coordinate of camera in world coordinates
+   * @param y y coordinate of camera in world coordinates
+   */
+  void SetPositionHint(double x, double y) { workspace_.SetPositionHint(x, y); }
+
+  /**
+   * @brief Removes the position hint of the own workspace, e.g. after the localization got lost.
+   * All IDs of the map are accepted again.
+   */
+  void ClearPositionHint() { workspace_.ClearPositionHint(); }
 
   // parameters for point detection
   cv::SimpleBlobDetector::Params blobParams;
@@ -68,7 +224,7 @@ class LandmarkFinder {
   // parameters for clustering
   double maxRadiusForCluster; /**< Maximum radius for clustering marker points to landmarks*/
   uint16_t minPointsPerLandmark; /**< Minimum count of marker points per landmark (0)*/
-  uint16_t maxPointsPerLandmark; /**< Maximum count of marker points per landmark (depends on grid used)*/
+  uint16_t extraPointsPerLandmark; /**< Count of marker points a cluster may have beyond the largest landmark of the map, e.g. reflections (3)*/
 
   // parameters for corner hypotheses
   int maxCornerHypotheses; /**< Maximum number of corner hypotheses which are still considered*/
@@ -82,14 +238,51 @@ class LandmarkFinder {
   double idPointThresholdBackwards; /**< Threshold for id points in image for backwards calculation*/
 
  private:
-  static constexpr int DIM = 4;
+  friend class LandmarkFinderStages; /**< Runs the single stages in the benchmarks */
+
+  LandmarkMapHandle::Ptr map_handle_; /**< Handle new maps get published to */
+  VisibilityTable::ConstPtr visibility_table_; /**< Optional visible IDs per floor cell */
+  Workspace workspace_; /**< Workspace of DetectLandmarks calls without explicit workspace */
+
+  typedef std::pmr::vector<cv::Point> ScratchPoints;     /**< Points in the frame arena */
+  typedef std::pmr::vector<cv::Point2f> ScratchPoints2f; /**< Points in the frame arena */
+
+  /**
+   * @brief Range of points of a single cluster
+   */
+  struct PointRange {
+    const cv::Point* first;
+    const cv::Point* last;
+    const cv::Point* begin() const { return first; }
+    const cv::Point* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    const cv::Point& operator[](size_t i) const { return first[i]; }
+  };
+
+  /**
+   * @brief Point clusters of a frame in the frame arena, stored as compressed rows. The points of
+   * cluster c are points[offsets[c]] to points[offsets[c + 1] - 1], in the order of the blob list.
+   */
+  struct ScratchClusters {
+    std::pmr::vector<uint32_t> offsets; /**< Start of every cluster in points, plus end marker */
+    std::pmr::vector<cv::Point> points; /**< Points of all clusters, concatenated */
+    std::pmr::vector<uint32_t> indices; /**< Index of every point in the blob list */
+
+    explicit ScratchClusters(std::pmr::memory_resource* arena)
+        : offsets(1, 0, arena), points(arena), indices(arena) {}
+    size_t size() const { return offsets.size() - 1; }
+    PointRange operator[](size_t c) const {
+      return PointRange{points.data() + offsets[c], points.data() + offsets[c + 1]};
+    }
+  };
 
   /**
    * @brief Uses SimpleBlobDetection for point detection
    *
-   * @param img_in raw image
+   * @param workspace Per-call state, provides the grayvalue image
+   * @param points Output points
    */
-  std::vector<cv::Point> FindBlobs(cv::Mat& img_in) const;
+  void FindBlobs(Workspace& workspace, ScratchPoints& points) const;
 
   /**
    * @brief Finds hypotheses for landmarks by clustering the input points
@@ -100,8 +293,8 @@ class LandmarkFinder {
    * @param minPointsThreshold
    * @param maxPointsThreshold
    */
-  void FindClusters(const std::vector<cv::Point>& points_in,
-                    std::vector<Cluster>& clusters,
+  void FindClusters(const ScratchPoints& points_in,
+                    ScratchClusters& clusters,
                     const double radiusThreshold,
                     const unsigned int minPointsThreshold,
                     const unsigned int maxPointsThreshold) const;
@@ -111,42 +304,58 @@ class LandmarkFinder {
    * point cluster. It utilizes a score function to find good triples.
    *
    * @param points cluster of points
-   * @return std::vector<ImgLandmark> reasonable hypotheses
+   * @param arena Memory resource for scratch data
+   * @param hypotheses Output vector, reasonable hypotheses are appended
+   * @return uint64_t Number of point triples evaluated
    */
-  std::vector<ImgLandmark> FindCorners(const std::vector<cv::Point>& points);
+  uint64_t FindCorners(const PointRange& points,
+                   std::pmr::memory_resource* arena,
+                   std::vector<ImgLandmark>& hypotheses) const;
 
   /**
-   * @brief Finds valid landmark observations from the input hypotheses
+   * @brief Finds valid landmark observations from the point clusters
    *
    * @param clusteredPoints
-   * @return std::vector<ImgLandmark>
+   * @param workspace Per-call state
+   * @param landmarks Output vector of landmarks
    */
-  std::vector<ImgLandmark> FindLandmarks(const std::vector<Cluster>& clusteredPoints);
+  void FindLandmarks(const ScratchClusters& clusteredPoints,
+                     Workspace& workspace,
+                     std::vector<ImgLandmark>& landmarks) const;
 
   /**
    * @brief Tries to identify the landmarks ID
    *
+   * @tparam Family Layout of the landmarks, see ::LandmarkFamily
    * @param landmarks vector of observations
+   * @param workspace Per-call state, provides image, arena, map snapshot and position hint
    */
-  void GetIDs(std::vector<ImgLandmark>& landmarks);
+  template <typename Family>
+  void GetIDs(std::vector<ImgLandmark>& landmarks, Workspace& workspace) const;
 
   /**
    * @brief Tries to calculate the landmarks id by transforming the observed
    * points into unary landmark coordinates.
    *
+   * @tparam Family Layout of the landmarks, see ::LandmarkFamily
    * @param landmark
-   * @return uint16_t calculated ID
+   * @param local_points Scratch vector for the transformed points
+   * @return landmark_id_t calculated ID
    */
-  uint16_t CalculateIdForward(const ImgLandmark& landmark) const;
+  template <typename Family>
+  landmark_id_t CalculateIdForward(const ImgLandmark& landmark, ScratchPoints2f& local_points) const;
 
   /**
    * @brief   Tryies to calculate the landmarks id by looking in the filtered
    * image, whether a bright point can be seen where it is assumed.
    *
+   * @tparam Family Layout of the landmarks, see ::LandmarkFamily
    * @param landmark
+   * @param grayImage grayvalue image the landmark was found in
    * @return bool
    */
-  bool CalculateIdBackward(ImgLandmark& landmark) const;
+  template <typename Family>
+  bool CalculateIdBackward(ImgLandmark& landmark, const cv::Mat& grayImage) const;
 
   /**
    * @brief Transforms global point coordinates to local landmark coordinates
@@ -159,23 +368,10 @@ class LandmarkFinder {
   void TransformToLocalPoints(const cv::Point2f& x0y0,
                               const cv::Point2f& x1y0,
                               const cv::Point2f& x1y1,
-                              std::vector<cv::Point2f>& p) const;
-
-  /**
-   * @brief Transforms local point coordinates to global image coordinates
-   *
-   * @param x0y0 Global coordinates of corner (local x=0 y=0)
-   * @param x1y0 Global coordinates of corner (local x=1 y=0)
-   * @param x1y1 Global coordinates of corner (local x=1 y=1)
-   * @param p vector of points to transform
-   */
-  void TransformToGlobalPoints(const cv::Point2f& x0y0,
-                               const cv::Point2f& x1y0,
-                               const cv::Point2f& x1y1,
-                               std::vector<cv::Point2f>& p) const;
+                              ScratchPoints2f& p) const;
 
   template <typename T>
-  inline bool isInside(T value, T lower, T upper, T tol) {
+  static bool isInside(T value, T lower, T upper, T tol) {
     return value > lower - tol && value < upper + tol;
   }
 };
@@ -0,0 +1,91 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StargazerTypes.h"
+
+namespace stargazer {
+
+/**
+ * @brief Uniform 2D grid over the x-y-plane of the world frame. Every landmark is registered in
+ * all cells its world points cover, so area queries only touch landmarks nearby.
+ */
+class LandmarkGrid {
+ public:
+  /**
+   * @brief Default constructor, creates an empty grid.
+   */
+  LandmarkGrid() {}
+
+  /**
+   * @brief Constructor.
+   *
+   * @param world_landmarks Map of landmarks. Points have to be defined in world coordinates!
+   * @param cell_size Edge length of a grid cell in meters
+   */
+  LandmarkGrid(const landmark_map_t& world_landmarks, double cell_size = 1.0);
+
+  /**
+   * @brief Collects the ids of all landmarks, which have points inside the given box.
+   *
+   * @param x_min Lower x bound of box in world coordinates
+   * @param y_min Lower y bound of box in world coordinates
+   * @param x_max Upper x bound of box in world coordinates
+   * @param y_max Upper y bound of box in world coordinates
+   * @param ids Output vector of ascending, unique ids. Gets cleared first.
+   */
+  void QueryBox(double x_min,
+                double y_min,
+                double x_max,
+                double y_max,
+                std::vector<landmark_id_t>& ids) const;
+
+  /**
+   * @brief Updates the entries of some landmarks. Only the cells covered by these landmarks are
+   * recomputed, the entries of all other cells are copied as a block. The copy is still linear in
+   * the size of the grid.
+   *
+   * @param erased Removed or changed landmarks as they were inserted before, i.e. with their
+   * previous world points
+   * @param inserted Added or changed landmarks. Points have to be defined in world coordinates!
+   * @return bool False, if an inserted landmark lies outside of the grid. The grid is unchanged
+   * then and has to be rebuilt.
+   */
+  bool Update(const landmark_map_t& erased, const landmark_map_t& inserted);
+
+ private:
+  double cell_size_ = 1.;       /**< Edge length of a cell */
+  double x_origin_ = 0.;        /**< x coordinate of the lower cell border */
+  double y_origin_ = 0.;        /**< y coordinate of the lower cell border */
+  int cols_ = 0;                /**< Number of cells in x direction */
+  int rows_ = 0;                /**< Number of cells in y direction */
+  std::vector<uint32_t> cell_offsets_;  /**< Start of every cell in cell_ids_, plus end marker */
+  std::vector<landmark_id_t> cell_ids_; /**< Landmark ids of all cells, concatenated */
+
+  /**
+   * @brief Clamped cell index of a coordinate
+   */
+  int getCol(double x) const;
+  int getRow(double y) const;
+};
+
+}  // namespace stargazer
@@ -0,0 +1,256 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LandmarkGrid.h"
+#include "StargazerTypes.h"
+
+namespace stargazer {
+
+/**
+ * @brief Immutable map representation, that is shared between LandmarkFinder, Localizer and
+ * LandmarkCalibrator. It is loaded once and holds everything the components precompute from
+ * the map file.
+ */
+class LandmarkMap {
+ public:
+  typedef std::shared_ptr<const LandmarkMap> ConstPtr;
+
+  /**
+   * @brief Constructor. Loads the map file.
+   *
+   * @param mapfile Path to map file with landmark poses. Either a yaml map config (see
+   * ::writeMapConfig) or a binary map (see ::writeBinaryMap).
+   * @param family Layout of the landmarks of a yaml map config. Binary maps store their layout, it
+   * is used regardless of this parameter.
+   */
+  explicit LandmarkMap(const std::string& mapfile,
+                       LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4);
+
+  /**
+   * @brief Constructor.
+   *
+   * @param landmarks Map of landmarks. Points have to be defined in landmark coordinates!
+   * @param family Layout of the landmarks
+   */
+  explicit LandmarkMap(landmark_map_t landmarks,
+                       LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4);
+
+  /**
+   * @brief Getter for the layout of all landmarks of this map. The LandmarkFinder decodes IDs
+   * according to it.
+   *
+   * @return LANDMARK_FAMILY
+   */
+  LANDMARK_FAMILY getFamily() const { return family_; }
+
+  /**
+   * @brief Getter for the highest number of points of a single landmark (corners and ID points).
+   * Larger point clusters can not be a landmark of this map.
+   *
+   * @return size_t
+   */
+  size_t getMaxPointCount() const { return max_point_count_; }
+
+  /**
+   * @brief Getter for map of landmarks
+   *
+   * @return const landmark_map_t& Landmarks with points in landmark coordinates
+   */
+  const landmark_map_t& getLandmarks() const { return landmarks_; }
+
+  /**
+   * @brief Getter for map of landmarks, whose points have been transformed into world coordinates
+   *
+   * @return const landmark_map_t& Landmarks with points in world coordinates
+   */
+  const landmark_map_t& getWorldLandmarks() const { return world_landmarks_; }
+
+  /**
+   * @brief Getter for the ids of all landmarks
+   *
+   * @return const std::vector<landmark_id_t>& Ascending list of ids
+   */
+  const std::vector<landmark_id_t>& getIds() const { return ids_; }
+
+  /**
+   * @brief Checks whether a landmark with the given id is part of the map
+   *
+   * @param id Landmark ID
+   * @return bool
+   */
+  bool contains(landmark_id_t id) const;
+
+  /**
+   * @brief Getter for a hash of family, ids, poses and points of all landmarks. Maps with equal
+   * content have equal fingerprints, even if loaded from different files.
+   *
+   * @return uint64_t
+   */
+  uint64_t getFingerprint() const { return fingerprint_; }
+
+  /**
+   * @brief Getter for the lowest z value of all landmark points in world coordinates
+   *
+   * @return double
+   */
+  double getMinHeight() const { return min_height_; }
+
+  /**
+   * @brief Getter for the highest z value of all landmark points in world coordinates
+   *
+   * @return double
+   */
+  double getMaxHeight() const { return max_height_; }
+
+  /**
+   * @brief Getter for the spatial index over the landmarks' world points
+   *
+   * @return const LandmarkGrid&
+   */
+  const LandmarkGrid& getGrid() const { return grid_; }
+
+  /**
+   * @brief Finds all landmarks, which have at least one point inside the camera image. The
+   * grid is used to preselect the landmarks inside the viewing frustum, so only landmarks near
+   * the camera get projected.
+   *
+   * @param camera_pose Pose of the camera
+   * @param camera_intrinsics Camera parameters
+   * @param image_width Width of the camera image in pixels
+   * @param image_height Height of the camera image in pixels
+   * @param ids Output vector of ascending ids. Gets cleared first.
+   */
+  void getVisibleLandmarks(const pose_t& camera_pose,
+                           const camera_params_t& camera_intrinsics,
+                           int image_width,
+                           int image_height,
+                           std::vector<landmark_id_t>& ids) const;
+
+  /**
+   * @brief Creates a copy of this map with a delta applied, e.g. to publish it with
+   * LandmarkMapHandle::Publish. Only the world points of the changed landmarks and the grid cells
+   * they cover get recomputed. The landmarks and the grid are still copied, so the cost is linear
+   * in the size of the map.
+   *
+   * @param delta Changed and removed landmarks, of the same family as this map
+   * @return ConstPtr New map
+   */
+  ConstPtr Apply(const LandmarkMapDelta& delta) const;
+
+ private:
+  landmark_map_t landmarks_;       /**< Landmarks in landmark coordinates */
+  landmark_map_t world_landmarks_; /**< Landmarks in world coordinates */
+  std::vector<landmark_id_t> ids_; /**< Sorted ids of all landmarks */
+  LANDMARK_FAMILY family_;         /**< Layout of all landmarks */
+  size_t max_point_count_;         /**< Highest point count of a single landmark */
+  uint64_t fingerprint_;           /**< Hash of the landmarks in landmark coordinates */
+  double min_height_;              /**< Lowest z of all world points */
+  double max_height_;              /**< Highest z of all world points */
+  LandmarkGrid grid_;              /**< Spatial index over world points */
+
+  /**
+   * @brief Fills ids_, max_point_count_, the heights and the grid from world_landmarks_, and the
+   * fingerprint from landmarks_
+   */
+  void Init();
+};
+
+/**
+ * @brief Computes the landmarks, that have been added, moved or removed
+ *
+ * @param from Old map of landmarks
+ * @param to New map of landmarks
+ * @return LandmarkMapDelta Delta, that turns from into to
+ */
+LandmarkMapDelta computeMapDelta(const landmark_map_t& from, const landmark_map_t& to);
+
+/**
+ * @brief Applies a delta to a map of landmarks
+ *
+ * @param landmarks Map of landmarks to modify
+ * @param delta Changed and removed landmarks
+ */
+void applyMapDelta(landmark_map_t& landmarks, const LandmarkMapDelta& delta);
+
+/**
+ * @brief Publishes map snapshots to LandmarkFinder and Localizer instances, so that a new map can
+ * be loaded without restarting them (read-copy-update). A frame that is in progress keeps using
+ * the snapshot it started with, the next frame picks up the published map.
+ *
+ * Checking for a new map is a single atomic load. The internal mutex is only taken by
+ * LandmarkMapHandle::Publish and once per component after a map has been published.
+ */
+class LandmarkMapHandle {
+ public:
+  typedef std::shared_ptr<LandmarkMapHandle> Ptr;
+
+  /**
+   * @brief Constructor
+   *
+   * @param map Initial map
+   */
+  explicit LandmarkMapHandle(LandmarkMap::ConstPtr map);
+
+  /**
+   * @brief Replaces the current map. Components sharing this handle switch to the new map at
+   * their next frame.
+   *
+   * @param map New map
+   */
+  void Publish(LandmarkMap::ConstPtr map);
+
+  /**
+   * @brief Getter for the current map
+   *
+   * @return LandmarkMap::ConstPtr
+   */
+  LandmarkMap::ConstPtr Load() const;
+
+  /**
+   * @brief Getter for the generation of the current map. It is incremented on every call to
+   * LandmarkMapHandle::Publish.
+   *
+   * @return uint64_t
+   */
+  uint64_t getGeneration() const { return generation_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Replaces the snapshot by the current map, if a newer one has been published.
+   *
+   * @param snapshot Map snapshot of the caller
+   * @param generation Generation of the snapshot
+   * @return bool Whether the snapshot has been replaced
+   */
+  bool Update(LandmarkMap::ConstPtr& snapshot, uint64_t& generation) const;
+
+ private:
+  mutable std::mutex mutex_;          /**< Guards map_ */
+  LandmarkMap::ConstPtr map_;         /**< Current map */
+  std::atomic<uint64_t> generation_;  /**< Generation of map_ */
+};
+
+}  // namespace stargazer
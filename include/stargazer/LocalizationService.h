@@ -0,0 +1,174 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LandmarkFinder.h"
+#include "LandmarkMap.h"
+#include "Localizer.h"
+#include "StargazerImgTypes.h"
+#include "StargazerTypes.h"
+#include "internal/BoundedQueue.h"
+#include "internal/WorkStealingPool.h"
+
+namespace stargazer {
+
+/**
+ * @brief Localizes the frames of many camera streams on a shared thread pool. All streams share
+ * one LandmarkFinder and one map, every stream only keeps its own localizer, detection workspace
+ * and a small frame queue. The frames of a stream are processed one after the other, frames of
+ * different streams run in parallel. Every stream processes a single frame per turn and queues up
+ * behind the others afterwards, so all streams are served fairly.
+ */
+class LocalizationService {
+ public:
+  /**
+   * @brief Result of a processed frame
+   */
+  struct Result {
+    size_t stream = 0;                        /**< Stream, the frame belongs to */
+    uint64_t frame_id = 0;                    /**< Number of the frame, as returned by Push */
+    pose_t pose = {{0., 0., 0., 0., 0., 0.}}; /**< Camera pose computed by the localizer */
+    std::vector<ImgLandmark> landmarks;       /**< Detected landmarks */
+  };
+
+  /**
+   * @brief Receives the results of a stream. It is called from the worker threads, but never
+   * concurrently for the same stream.
+   */
+  typedef std::function<void(const Result&)> ResultCallback;
+
+  /**
+   * @brief Constructor. Starts the worker threads.
+   *
+   * @param map_handle Handle to the shared map, it should be passed to the localizers as well
+   * @param thread_count Number of worker threads
+   */
+  explicit LocalizationService(LandmarkMapHandle::Ptr map_handle,
+                               size_t thread_count = std::thread::hardware_concurrency());
+
+  /**
+   * @brief Destructor. Stops the service.
+   */
+  ~LocalizationService();
+
+  LocalizationService(const LocalizationService&) = delete;
+  LocalizationService& operator=(const LocalizationService&) = delete;
+
+  /**
+   * @brief Getter for the shared finder, e.g. to set its parameters or a visibility table. It must
+   * not be modified while frames are processed.
+   *
+   * @return LandmarkFinder&
+   */
+  LandmarkFinder& getFinder() { return finder_; }
+
+  /**
+   * @brief Adds a camera stream.
+   *
+   * @param localizer Localizer of this stream, it is used by the service exclusively
+   * @param callback Receiver of the results of this stream
+   * @param queue_size Number of frames waiting for processing. If the stream falls behind, its
+   * oldest frames are dropped.
+   * @return size_t Index of the stream
+   */
+  size_t AddStream(std::unique_ptr<Localizer> localizer, ResultCallback callback, size_t queue_size = 2);
+
+  /**
+   * @brief Hands a frame of a stream to the service.
+   *
+   * @param stream Index of the stream, as returned by AddStream
+   * @param img Camera image, it must not be modified until the frame has been processed
+   * @param dt Time since the last frame of this stream
+   * @return uint64_t Number of the frame within its stream
+   * @throws The exception, a previous frame of this stream failed with
+   * @throws std::runtime_error If the service has been stopped
+   */
+  uint64_t Push(size_t stream, const cv::Mat& img, float dt);
+
+  /**
+   * @brief Getter for the number of frames of a stream, that have been dropped so far
+   *
+   * @param stream Index of the stream
+   * @return uint64_t
+   */
+  uint64_t getDroppedCount(size_t stream) const;
+
+  /**
+   * @brief Waits for the frames in progress and stops the worker threads. Queued frames are
+   * discarded, further frames are rejected.
+   */
+  void Stop() { pool_.Stop(); }
+
+ private:
+  struct Frame {
+    uint64_t frame_id = 0;
+    cv::Mat img;
+    float dt = 0.f;
+  };
+
+  /**
+   * @brief State of a single camera stream
+   */
+  struct Stream {
+    Stream(size_t index, std::unique_ptr<Localizer> localizer, ResultCallback callback, size_t queue_size)
+        : index(index), localizer(std::move(localizer)), callback(std::move(callback)), frames(queue_size) {}
+
+    const size_t index;                       /**< Index of this stream */
+    std::unique_ptr<Localizer> localizer;     /**< Pose of this stream */
+    ResultCallback callback;                  /**< Receiver of the results */
+    LandmarkFinder::Workspace workspace;      /**< Detection state and scratch memory */
+    BoundedQueue<Frame> frames;               /**< Frames waiting for processing */
+    std::atomic<bool> is_scheduled{false};    /**< Whether a task of this stream is queued or running */
+    std::atomic<uint64_t> next_frame_id{0};   /**< Number of the next pushed frame */
+    std::atomic<uint64_t> dropped{0};         /**< Number of dropped frames */
+    std::mutex error_mutex;                   /**< Guards error */
+    std::exception_ptr error;                 /**< First exception thrown while processing */
+  };
+
+  LandmarkFinder finder_;                       /**< Detection of all streams */
+  mutable std::mutex streams_mutex_;            /**< Guards streams_ */
+  std::vector<std::unique_ptr<Stream>> streams_; /**< All streams */
+  WorkStealingPool pool_; /**< Workers, declared last to stop them before the streams get destroyed */
+
+  Stream& getStream(size_t stream) const;
+
+  /**
+   * @brief Queues a task for the stream, unless one is queued or running already
+   *
+   * @return bool False, if the service has been stopped
+   */
+  bool Schedule(Stream& stream);
+
+  /**
+   * @brief Processes the oldest frame of a stream and schedules the stream again, if more frames
+   * are waiting
+   */
+  void Process(Stream& stream);
+};
+
+}  // namespace stargazer
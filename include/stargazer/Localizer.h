@@ -18,8 +18,13 @@
 
 #pragma once
 
+#include <chrono>
+
+#include "LandmarkMap.h"
+#include "PosePublisher.h"
 #include "StargazerConfig.h"
 #include "StargazerImgTypes.h"
+#include "StargazerStats.h"
 #include "StargazerTypes.h"
 
 namespace stargazer {
@@ -32,9 +37,13 @@ class Localizer {
 
  public:
   /**
-   * @brief Default stub constructor
+   * @brief Default stub constructor. The localizer starts with an empty map.
    */
-  Localizer(){};
+  Localizer()
+      : map_handle_(std::make_shared<LandmarkMapHandle>(
+            std::make_shared<const LandmarkMap>(landmark_map_t()))) {
+    map_handle_->Update(map_, map_generation_);
+  };
 
   /**
    * @brief Constructor.
@@ -42,15 +51,35 @@ class Localizer {
    * @param cfgfile Path to map file with camera intrinsics and landmark poses.
    * @remark The config file has to be generated with ::writeConfig!
    */
-  Localizer(const std::string& cam_cfgfile, const std::string& map_cfgfile) {
+  Localizer(const std::string& cam_cfgfile, const std::string& map_cfgfile)
+      : Localizer(cam_cfgfile, std::make_shared<const LandmarkMap>(map_cfgfile)){};
+
+  /**
+   * @brief Constructor.
+   *
+   * @param cam_cfgfile Path to config file with camera intrinsics.
+   * @param map Shared map with landmark poses.
+   */
+  Localizer(const std::string& cam_cfgfile, LandmarkMap::ConstPtr map)
+      : Localizer(cam_cfgfile, std::make_shared<LandmarkMapHandle>(std::move(map))){};
+
+  /**
+   * @brief Constructor.
+   *
+   * @param cam_cfgfile Path to config file with camera intrinsics.
+   * @param map_handle Handle to the shared map. Maps published to it are used from the next
+   * call to Localizer::UpdatePose on.
+   */
+  Localizer(const std::string& cam_cfgfile, LandmarkMapHandle::Ptr map_handle)
+      : map_handle_(std::move(map_handle)) {
     readCamConfig(cam_cfgfile, camera_intrinsics);
-    readMapConfig(map_cfgfile, landmarks);
+    map_handle_->Update(map_, map_generation_);
   };
 
   /**
    * @brief Default destructor
    */
-  ~Localizer(){};
+  virtual ~Localizer(){};
 
   /**
    * @brief Main update method. Computes pose from landmark observations and stores it in Localizer::ego_pose
@@ -60,6 +89,27 @@ class Localizer {
    */
   virtual void UpdatePose(std::vector<ImgLandmark>& img_landmarks, float dt) = 0;
 
+  /**
+   * @brief Update method for landmarks, that were detected on a specific map snapshot (see
+   * LandmarkFinder::Workspace::map). The pose is computed on that snapshot, so IDs removed by a
+   * map published in the meantime are still known. The next update without snapshot switches to
+   * the most recently published map again.
+   *
+   * @param img_landmarks Vector of all observed landmarks in image coordinates
+   * @param dt Time since last update
+   * @param map Map snapshot the landmarks were detected on, nullptr for the most recent map
+   */
+  void UpdatePose(std::vector<ImgLandmark>& img_landmarks, float dt, LandmarkMap::ConstPtr map) {
+    detection_map_ = std::move(map);
+    try {
+      UpdatePose(img_landmarks, dt);
+    } catch (...) {
+      detection_map_.reset();
+      throw;
+    }
+    detection_map_.reset();
+  }
+
   /**
    * @brief Getter for computed pose from last call to Localizer::UpdatePose
    *
@@ -67,12 +117,34 @@ class Localizer {
    */
   const pose_t getPose() const { return ego_pose; }
 
+  /**
+   * @brief Computes the covariance of the pose from the last call to Localizer::UpdatePose.
+   *
+   * @param covariance Output covariance
+   * @return bool False, if the localizer can not provide a covariance
+   */
+  virtual bool ComputePoseCovariance(pose_covariance_t& /*covariance*/) { return false; }
+
   /**
    * @brief Getter for map of landmarks
    *
-   * @return const std::map<int, Landmark>
+   * @return const landmark_map_t& Landmarks with points in world coordinates
    */
-  const std::map<int, Landmark>& getLandmarks() const { return landmarks; }
+  const landmark_map_t& getLandmarks() const { return map_->getWorldLandmarks(); }
+
+  /**
+   * @brief Getter for the snapshot of the shared map
+   *
+   * @return const LandmarkMap::ConstPtr&
+   */
+  const LandmarkMap::ConstPtr& getMap() const { return map_; }
+
+  /**
+   * @brief Getter for the handle, new maps can be published to
+   *
+   * @return const LandmarkMapHandle::Ptr&
+   */
+  const LandmarkMapHandle::Ptr& getMapHandle() const { return map_handle_; }
 
   /**
    * @brief Getter for the cameras' intrinsic parameters
@@ -81,8 +153,75 @@ class Localizer {
    */
   const camera_params_t& getIntrinsics() const { return camera_intrinsics; }
 
+  /**
+   * @brief Publishes every pose computed by Localizer::UpdatePose from now on. Readers poll the
+   * publisher without ever blocking the localizer.
+   *
+   * @param publisher Publisher, nullptr to stop publishing
+   * @param with_covariance Whether to compute and publish the covariance of every pose
+   */
+  void SetPosePublisher(PosePublisher::Ptr publisher, bool with_covariance = false) {
+    pose_publisher_ = std::move(publisher);
+    publish_covariance_ = with_covariance;
+  }
+
+  /**
+   * @brief Getter for the pose publisher
+   *
+   * @return const PosePublisher::Ptr& nullptr, if poses are not published
+   */
+  const PosePublisher::Ptr& getPosePublisher() const { return pose_publisher_; }
+
+  /**
+   * @brief Sets a stats struct, that receives stage timings and counts of every call to
+   * Localizer::UpdatePose.
+   *
+   * @param stats Receiver of the stats, has to outlive the localizer (nullptr to disable)
+   */
+  void SetStats(LocalizationStats* stats) { stats_ = stats; }
+
  protected:
-  std::map<int, Landmark> landmarks; /**< Map of landmarks, read from config */
+  /**
+   * @brief Switches to the map snapshot of the detection, if one is given, or else to the most
+   * recently published map. Has to be called at the beginning of Localizer::UpdatePose.
+   *
+   * @return bool Whether the map has changed
+   */
+  bool UpdateMap() {
+    if (!detection_map_) {
+      return map_handle_->Update(map_, map_generation_);
+    }
+    if (detection_map_ == map_) {
+      return false;
+    }
+    map_ = detection_map_;
+    map_generation_ = 0;  // Generations start at 1, so the next update fetches the handle's map
+    return true;
+  }
+
+  /**
+   * @brief Publishes Localizer::ego_pose, if a publisher is set. Has to be called at the end of
+   * Localizer::UpdatePose.
+   */
+  void PublishPose() {
+    if (!pose_publisher_) {
+      return;
+    }
+    PoseSnapshot snapshot;
+    snapshot.pose = ego_pose;
+    snapshot.has_covariance = publish_covariance_ && ComputePoseCovariance(snapshot.covariance);
+    snapshot.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    pose_publisher_->Publish(snapshot);
+  }
+
+  LandmarkMapHandle::Ptr map_handle_; /**< Handle new maps get published to */
+  LandmarkMap::ConstPtr map_;         /**< Snapshot of the shared map of landmarks */
+  uint64_t map_generation_ = 0;       /**< Generation of the snapshot */
+  LandmarkMap::ConstPtr detection_map_; /**< Map snapshot of the running update, if given */
+  PosePublisher::Ptr pose_publisher_; /**< Receiver of every computed pose, may be nullptr */
+  bool publish_covariance_ = false;   /**< Whether to publish the covariance along with the pose */
+  LocalizationStats* stats_ = nullptr; /**< Optional receiver of stage timings and counts (not owned) */
   camera_params_t camera_intrinsics = {{0., 0., 0., 0.}}; /**< Parameters of camera, read from config*/
   pose_t ego_pose = {{0., 0., 0., 0., 0., 0.}}; /**< Ego pose as computed by last call to Localizer::UpdatePose */
 };
@@ -0,0 +1,153 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "StargazerTypes.h"
+#include "internal/SeqLock.h"
+
+namespace stargazer {
+
+/**
+ * @brief Latest pose of a localizer, as published by PosePublisher
+ */
+struct PoseSnapshot {
+  pose_t pose = {{0., 0., 0., 0., 0., 0.}}; /**< Camera pose */
+  pose_covariance_t covariance = {};       /**< Covariance of the pose, if has_covariance */
+  uint64_t timestamp = 0;    /**< Time of the update, nanoseconds of std::chrono::steady_clock */
+  bool has_covariance = false; /**< Whether covariance is set */
+};
+
+/**
+ * @brief Publishes the latest pose to any number of readers, e.g. controllers polling at high
+ * rate. Readers never block the publisher and never see a partially written pose. Optionally, the
+ * pose is placed in a POSIX shared memory segment, which other local processes read with a
+ * PoseReader.
+ */
+class PosePublisher {
+ public:
+  typedef std::shared_ptr<PosePublisher> Ptr;
+
+  /**
+   * @brief Constructor. The pose is only visible within this process.
+   */
+  PosePublisher();
+
+  /**
+   * @brief Constructor. Creates a shared memory segment, that belongs to this publisher.
+   *
+   * @param shm_name Name of the segment, e.g. "/stargazer_pose"
+   * @throws std::runtime_error if the segment exists already or can not be created. A segment
+   * left behind by a crashed publisher has to be removed first, e.g. from /dev/shm.
+   */
+  explicit PosePublisher(const std::string& shm_name);
+
+  /**
+   * @brief Destructor. Removes the shared memory segment, attached readers keep their mapping.
+   */
+  ~PosePublisher();
+
+  PosePublisher(const PosePublisher&) = delete;
+  PosePublisher& operator=(const PosePublisher&) = delete;
+
+  /**
+   * @brief Publishes a pose. Must not be called concurrently.
+   *
+   * @param snapshot Pose
+   */
+  void Publish(const PoseSnapshot& snapshot);
+
+  /**
+   * @brief Reads the latest pose with a single attempt. Wait-free.
+   *
+   * @param snapshot Output pose, only written on success
+   * @return bool False, if the pose was being written
+   */
+  bool TryRead(PoseSnapshot& snapshot) const;
+
+  /**
+   * @brief Reads the latest pose, retrying while it is being written.
+   *
+   * @return PoseSnapshot
+   */
+  PoseSnapshot Read() const;
+
+  /**
+   * @brief Getter for the number of published poses
+   */
+  uint64_t getVersion() const;
+
+ private:
+  friend class PoseReader;
+  struct Segment;
+
+  Segment* segment_ = nullptr;     /**< Either local_ or the shared memory mapping */
+  std::unique_ptr<Segment> local_; /**< Process-local segment */
+  std::string shm_name_;           /**< Name of the shared memory segment, empty if local */
+};
+
+/**
+ * @brief Reads the poses published by a PosePublisher of another process.
+ */
+class PoseReader {
+ public:
+  /**
+   * @brief Constructor. Attaches to a shared memory segment.
+   *
+   * @param shm_name Name of the segment, as given to the publisher
+   * @throws std::runtime_error if the segment does not exist or is invalid
+   */
+  explicit PoseReader(const std::string& shm_name);
+
+  /**
+   * @brief Destructor. Detaches from the segment.
+   */
+  ~PoseReader();
+
+  PoseReader(const PoseReader&) = delete;
+  PoseReader& operator=(const PoseReader&) = delete;
+
+  /**
+   * @brief Reads the latest pose with a single attempt. Wait-free.
+   *
+   * @param snapshot Output pose, only written on success
+   * @return bool False, if the pose was being written
+   */
+  bool TryRead(PoseSnapshot& snapshot) const;
+
+  /**
+   * @brief Reads the latest pose, retrying while it is being written.
+   *
+   * @return PoseSnapshot
+   */
+  PoseSnapshot Read() const;
+
+  /**
+   * @brief Getter for the number of published poses
+   */
+  uint64_t getVersion() const;
+
+ private:
+  const PosePublisher::Segment* segment_ = nullptr; /**< Shared memory mapping */
+};
+
+}  // namespace stargazer
@@ -0,0 +1,130 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "LandmarkMap.h"
+#include "StargazerImgTypes.h"
+#include "StargazerTypes.h"
+
+namespace stargazer {
+
+/**
+ * @brief Synthetic camera image together with its ground truth
+ */
+struct SceneFrame {
+  cv::Mat image;                      /**< Grayvalue image (CV_8UC1) */
+  pose_t pose;                        /**< Camera pose the image was rendered from */
+  std::vector<ImgLandmark> landmarks; /**< Landmarks with all LEDs lit and inside the image */
+};
+
+/**
+ * @brief Renders camera images of a landmark map, e.g. to benchmark or test the LandmarkFinder
+ * and Localizer with arbitrarily large, labeled datasets. Every LED is projected with
+ * ::transformLandMarkToImage and drawn as a bright, saturated spot, whose size depends on its
+ * distance. Noise, blur, distractor reflections and dark LEDs can be added.
+ *
+ * @remark Given the same seed, the same sequence of Render calls yields the same images.
+ */
+class SceneRenderer {
+ public:
+  /**
+   * @brief Rendering parameters
+   */
+  struct Options {
+    int imageWidth = 1280;             /**< Width of the image in pixels */
+    int imageHeight = 960;             /**< Height of the image in pixels */
+    double ledRadius = 0.01;           /**< Radius of an LED in meters */
+    double ledIntensity = 400.;        /**< Peak grayvalue of an LED, values above 255 saturate */
+    double backgroundIntensity = 10.;  /**< Grayvalue of the background */
+    double noiseSigma = 0.;            /**< Standard deviation of the pixel noise in grayvalues */
+    double blurSigma = 0.;             /**< Standard deviation of the blur in pixels, 0 disables it */
+    int reflectionCount = 0;           /**< Number of distractor reflections per image */
+    double reflectionRadius = 4.;      /**< Maximum radius of a reflection in pixels */
+    double dropoutProbability = 0.;    /**< Probability of an LED being dark */
+    uint32_t seed = 0;                 /**< Seed of all random numbers */
+  };
+
+  /**
+   * @brief Constructor
+   *
+   * @param map Map of the landmarks to render
+   * @param camera_intrinsics Camera parameters
+   * @param options Rendering parameters
+   */
+  SceneRenderer(LandmarkMap::ConstPtr map, const camera_params_t& camera_intrinsics, const Options& options);
+
+  /**
+   * @brief Renders the image seen from a camera pose
+   *
+   * @param camera_pose Pose of the camera
+   * @return SceneFrame Image and ground truth. The ID points of every landmark are sorted by
+   * ascending bit, as generated by ::getLandmarkPoints.
+   */
+  SceneFrame Render(const pose_t& camera_pose);
+
+  /**
+   * @brief Renders the images along a trajectory
+   *
+   * @param trajectory Camera poses
+   * @return std::vector<SceneFrame> One frame per pose
+   */
+  std::vector<SceneFrame> Render(const std::vector<pose_t>& trajectory);
+
+  /**
+   * @brief Getter for the rendering parameters
+   */
+  const Options& getOptions() const { return options_; }
+
+ private:
+  /**
+   * @brief Adds a round spot to a float image
+   *
+   * @param image CV_32FC1 image
+   * @param u Column of the center
+   * @param v Row of the center
+   * @param radius Radius of the saturated core in pixels
+   * @param intensity Peak grayvalue
+   */
+  static void DrawSpot(cv::Mat& image, double u, double v, double radius, double intensity);
+
+  LandmarkMap::ConstPtr map_;         /**< Map of landmarks */
+  camera_params_t camera_intrinsics_; /**< Camera parameters */
+  Options options_;                   /**< Rendering parameters */
+  std::mt19937 rng_;                  /**< Source of all random numbers */
+};
+
+/**
+ * @brief Writes rendered frames to a directory: the images as frame_00000.png, ... and their
+ * ground truth as groundtruth.yaml, with one entry per frame holding the pose and the IDs of
+ * the landmarks.
+ *
+ * @param directory Existing output directory
+ * @param frames Rendered frames
+ * @throws std::runtime_error if a file can not be written
+ */
+void writeSceneFrames(const std::string& directory, const std::vector<SceneFrame>& frames);
+
+}  // namespace stargazer
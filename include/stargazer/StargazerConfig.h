@@ -18,85 +18,179 @@
 
 #pragma once
 
-#include <fstream>
-#include <iomanip>
-#include <iostream>
+#include <algorithm>
+#include <array>
 #include <string>
-
-#include <yaml-cpp/yaml.h>
+#include <string_view>
 
 #include "StargazerTypes.h"
+#include "internal/ConfigReader.h"
+#include "internal/ConfigWriter.h"
 
 namespace stargazer {
 
-inline YAML::Node loadYaml(const std::string& cfgfile) {
-  YAML::Node config;
-  try {
-    config = YAML::LoadFile(cfgfile);
-  } catch (YAML::BadFile& /*e*/) {
-    std::string msg = "Stargazer config file does not exist: " + cfgfile;
-    throw std::runtime_error(msg);
-  } catch (YAML::ParserException& /*e*/) {
-    std::string msg = "Wrong YAML syntax in stargazer config file: " + cfgfile;
-    throw std::runtime_error(msg);
-  }
-  return config;
-}
-
 /**
  * @brief
  *
  * @param cfgfile
  * @param camera_intrinsics
+ * @throws std::runtime_error with line and column, if the file is invalid
  */
 inline void readCamConfig(const std::string& cfgfile, camera_params_t& camera_intrinsics) {
-  YAML::Node config(loadYaml(cfgfile));
-
-  if (config["CameraIntrinsics"]) {
-    camera_intrinsics[(int)INTRINSICS::fu] =
-        config["CameraIntrinsics"]["fu"].as<double>();
-    camera_intrinsics[(int)INTRINSICS::fv] =
-        config["CameraIntrinsics"]["fv"].as<double>();
-    camera_intrinsics[(int)INTRINSICS::u0] =
-        config["CameraIntrinsics"]["u0"].as<double>();
-    camera_intrinsics[(int)INTRINSICS::v0] =
-        config["CameraIntrinsics"]["v0"].as<double>();
-  } else {
+  static constexpr std::array<const char*, (int)INTRINSICS::N_PARAMS> kKeys = {
+      {"fu", "fv", "u0", "v0"}};
+
+  ConfigReader reader(cfgfile);
+  bool found = false;
+  std::string_view section;
+  while (reader.NextSection(section)) {
+    if (section != "CameraIntrinsics") {
+      reader.SkipSection();
+      continue;
+    }
+    found = true;
+    const size_t begin = reader.getPosition();
+    std::array<bool, kKeys.size()> is_set{};
+    reader.ReadMapping(0, [&](std::string_view key) {
+      for (size_t i = 0; i < kKeys.size(); i++) {
+        if (key == kKeys[i]) {
+          camera_intrinsics[i] = reader.ReadDouble();
+          is_set[i] = true;
+          return true;
+        }
+      }
+      return false;
+    });
+    for (size_t i = 0; i < kKeys.size(); i++) {
+      if (!is_set[i]) {
+        reader.FailAt(begin, std::string("CameraIntrinsics is missing ") + kKeys[i]);
+      }
+    }
+  }
+  if (!found) {
     std::string msg =
         "Stargazer camera config file is missing CameraIntrinics!: " + cfgfile;
     throw std::runtime_error(msg);
   }
 }
 
+/**
+ * @brief Reads the sequence of landmarks of the current section
+ *
+ * @param reader Reader positioned at the sequence
+ * @param landmarks Output map, landmarks are added to it
+ * @param family Layout of the landmarks, used to generate their points
+ */
+inline void readLandmarks(ConfigReader& reader, landmark_map_t& landmarks, LANDMARK_FAMILY family) {
+  // HexID followed by the pose parameters, see ::POSE
+  static constexpr std::array<const char*, 1 + (int)POSE::N_PARAMS> kKeys = {
+      {"HexID", "x", "y", "z", "rx", "ry", "rz"}};
+
+  landmark_id_t id = 0;
+  pose_t lm_pose;
+  std::array<bool, kKeys.size()> is_set{};
+  reader.ReadSequence(
+      0,
+      [&](std::string_view key) {
+        if (key == kKeys[0]) {
+          id = reader.ReadUnsigned();
+          is_set[0] = true;
+          return true;
+        }
+        for (size_t i = 1; i < kKeys.size(); i++) {
+          if (key == kKeys[i]) {
+            lm_pose[i - 1] = reader.ReadDouble();
+            is_set[i] = true;
+            return true;
+          }
+        }
+        return false;
+      },
+      [&](size_t item) {
+        for (size_t i = 0; i < kKeys.size(); i++) {
+          if (!is_set[i]) {
+            reader.FailAt(item, std::string("Landmark is missing ") + kKeys[i]);
+          }
+        }
+        landmarks[id] = Landmark(id, family);
+        landmarks[id].pose = lm_pose;
+        is_set.fill(false);
+      });
+}
+
 /**
  * @brief
  *
  * @param cfgfile
  * @param landmarks
+ * @param family Layout of the landmarks, used to generate their points
+ * @throws std::runtime_error with line and column, if the file is invalid
  */
-inline void readMapConfig(const std::string& cfgfile, landmark_map_t& landmarks) {
-  YAML::Node config(loadYaml(cfgfile));
-
-  if (config["Landmarks"]) {
-    for (size_t i = 0; i < config["Landmarks"].size(); i++) {
-      auto lm = config["Landmarks"][i];
-      int id = lm["HexID"].as<int>();
-      pose_t lm_pose;
-      lm_pose[(int)POSE::X] = lm["x"].as<double>();
-      lm_pose[(int)POSE::Y] = lm["y"].as<double>();
-      lm_pose[(int)POSE::Z] = lm["z"].as<double>();
-      lm_pose[(int)POSE::Rx] = lm["rx"].as<double>();
-      lm_pose[(int)POSE::Ry] = lm["ry"].as<double>();
-      lm_pose[(int)POSE::Rz] = lm["rz"].as<double>();
-      landmarks[id] = Landmark(id);
-      landmarks[id].pose = lm_pose;
+inline void readMapConfig(const std::string& cfgfile,
+                          landmark_map_t& landmarks,
+                          LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4) {
+  ConfigReader reader(cfgfile);
+  bool found = false;
+  std::string_view section;
+  while (reader.NextSection(section)) {
+    if (section != "Landmarks") {
+      reader.SkipSection();
+      continue;
     }
-  } else {
+    found = true;
+    readLandmarks(reader, landmarks, family);
+  }
+  if (!found) {
     std::string msg = "Stargazer map config file is missing Landmarks!: " + cfgfile;
     throw std::runtime_error(msg);
   }
 }
 
+/**
+ * @brief Reads a map delta written with ::writeMapDelta
+ *
+ * @param cfgfile
+ * @param delta
+ * @param family Layout of the landmarks, used to generate their points
+ * @throws std::runtime_error with line and column, if the file is invalid
+ */
+inline void readMapDelta(const std::string& cfgfile,
+                         LandmarkMapDelta& delta,
+                         LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4) {
+  delta.changed.clear();
+  delta.removed.clear();
+
+  ConfigReader reader(cfgfile);
+  std::string_view section;
+  while (reader.NextSection(section)) {
+    if (section == "Landmarks") {
+      readLandmarks(reader, delta.changed, family);
+    } else if (section == "Removed") {
+      bool is_set = false;
+      reader.ReadSequence(
+          0,
+          [&](std::string_view key) {
+            if (key != "HexID") {
+              return false;
+            }
+            delta.removed.push_back(reader.ReadUnsigned());
+            is_set = true;
+            return true;
+          },
+          [&](size_t item) {
+            if (!is_set) {
+              reader.FailAt(item, "Removed landmark is missing HexID");
+            }
+            is_set = false;
+          });
+    } else {
+      reader.SkipSection();
+    }
+  }
+  std::sort(delta.removed.begin(), delta.removed.end());
+  delta.removed.erase(std::unique(delta.removed.begin(), delta.removed.end()), delta.removed.end());
+}
+
 /**
  * @brief
  *
@@ -104,7 +198,7 @@ inline void readMapConfig(const std::string& cfgfile, landmark_map_t& landmarks)
  * @param camera_intrinsics
  */
 inline void writeCamConfig(const std::string& cfgfile, const camera_params_t& camera_intrinsics) {
-  std::ofstream fout(cfgfile);
+  ConfigWriter fout;
 
   fout << "CameraIntrinsics:\n";
   fout << " fu: " << camera_intrinsics[(int)INTRINSICS::fu] << "\n";
@@ -112,7 +206,27 @@ inline void writeCamConfig(const std::string& cfgfile, const camera_params_t& ca
   fout << " u0: " << camera_intrinsics[(int)INTRINSICS::u0] << "\n";
   fout << " v0: " << camera_intrinsics[(int)INTRINSICS::v0] << "\n";
 
-  fout.close();
+  fout.Write(cfgfile);
+}
+
+/**
+ * @brief Writes a sequence of landmarks, one flow mapping per line
+ *
+ * @param fout Output buffer
+ * @param landmarks
+ */
+inline void writeLandmarks(ConfigWriter& fout, const landmark_map_t& landmarks) {
+  for (auto& entry : landmarks) {
+    fout << " - { HexID: ";
+    fout.AppendHexId(entry.first);
+    fout << ", x: " << entry.second.pose[(int)POSE::X];
+    fout << ", y: " << entry.second.pose[(int)POSE::Y];
+    fout << ", z: " << entry.second.pose[(int)POSE::Z];
+    fout << ", rx: " << entry.second.pose[(int)POSE::Rx];
+    fout << ", ry: " << entry.second.pose[(int)POSE::Ry];
+    fout << ", rz: " << entry.second.pose[(int)POSE::Rz];
+    fout << " }\n";
+  }
 }
 
 /**
@@ -122,24 +236,34 @@ inline void writeCamConfig(const std::string& cfgfile, const camera_params_t& ca
  * @param landmarks
  */
 inline void writeMapConfig(const std::string& cfgfile, const landmark_map_t& landmarks) {
-  std::ofstream fout(cfgfile);
+  ConfigWriter fout;
 
   fout << "Landmarks:\n";
-  for (auto& entry : landmarks) {
-    fout << " - {";
-    fout << " HexID: "
-         << "0x" << std::setfill('0') << std::setw(4) << std::hex << entry.first
-         << std::setfill(' ');
-    fout << ", x: " << std::setw(8) << entry.second.pose[(int)POSE::X];
-    fout << ", y: " << std::setw(8) << entry.second.pose[(int)POSE::Y];
-    fout << ", z: " << std::setw(8) << entry.second.pose[(int)POSE::Z];
-    fout << ", rx: " << std::setw(8) << entry.second.pose[(int)POSE::Rx];
-    fout << ", ry: " << std::setw(8) << entry.second.pose[(int)POSE::Ry];
-    fout << ", rz: " << std::setw(8) << entry.second.pose[(int)POSE::Rz];
+  writeLandmarks(fout, landmarks);
+
+  fout.Write(cfgfile);
+}
+
+/**
+ * @brief Writes a map delta. Only the changed landmarks and the ids of removed ones are written,
+ * in the format of ::writeMapConfig.
+ *
+ * @param cfgfile
+ * @param delta
+ */
+inline void writeMapDelta(const std::string& cfgfile, const LandmarkMapDelta& delta) {
+  ConfigWriter fout;
+
+  fout << "Landmarks:\n";
+  writeLandmarks(fout, delta.changed);
+  fout << "Removed:\n";
+  for (landmark_id_t id : delta.removed) {
+    fout << " - { HexID: ";
+    fout.AppendHexId(id);
     fout << " }\n";
   }
 
-  fout.close();
+  fout.Write(cfgfile);
 }
 
 }  // namespace stargazer
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <array>
+#include <type_traits>
 #include <vector>
 
 #include <opencv2/core/types.hpp>
@@ -31,22 +33,56 @@ namespace stargazer {
  */
 typedef std::vector<cv::Point> Cluster;
 
+/**
+ * @brief Pixel position of an observed landmark point. Unlike cv::Point it is trivially copyable.
+ * It converts to and from cv::Point implicitly.
+ */
+struct ImgPoint {
+  int x; /**< Column */
+  int y; /**< Row */
+
+  ImgPoint() = default;
+  constexpr ImgPoint(int x_, int y_) : x(x_), y(y_) {}
+  ImgPoint(const cv::Point& pt) : x(pt.x), y(pt.y) {}
+  operator cv::Point() const { return cv::Point(x, y); }
+  operator cv::Point2f() const { return cv::Point2f(static_cast<float>(x), static_cast<float>(y)); }
+};
+
 /**
  * @brief An image landmark holds the information of an observed landmark. All coordinates are in image coordinates.
+ * It is trivially copyable, so landmark vectors can be copied with memcpy, e.g. into queues or logs.
  */
 struct ImgLandmark {
-  uint16_t nID;                   /**< The detected ID of the landmark */
-  std::vector<cv::Point> corners; /**< The three corners of the landmark */
-  std::vector<cv::Point> idPoints; /**< The inner points of the landmark, which encode the ID */
+  static constexpr size_t kMaxIdPoints = LandmarkFamily6x6::kIdPointCount; /**< Of every ::LandmarkFamily */
+
+  landmark_id_t nID;                             /**< The detected ID of the landmark */
+  std::array<ImgPoint, 3> corners;               /**< The three corners of the landmark */
+  FixedVector<ImgPoint, kMaxIdPoints> idPoints;  /**< The inner points of the landmark, which encode the ID */
+
+  /**
+   * @brief Getter for the corners as vector, for code written against the former layout
+   *
+   * @return std::vector<cv::Point>
+   */
+  std::vector<cv::Point> getCorners() const { return std::vector<cv::Point>(corners.begin(), corners.end()); }
+
+  /**
+   * @brief Getter for the inner points as vector, for code written against the former layout
+   *
+   * @return std::vector<cv::Point>
+   */
+  std::vector<cv::Point> getIdPoints() const { return std::vector<cv::Point>(idPoints.begin(), idPoints.end()); }
 };
 
+static_assert(std::is_trivially_copyable<ImgLandmark>::value, "ImgLandmark has to be trivially copyable");
+
 /**
  * @brief Converts an ImgLandmrk to a Map Landmark
  *
  * @param lm_in
  * @return Landmark
  */
-inline Landmark convert2Landmark(ImgLandmark& lm_in) {
+inline Landmark convert2Landmark(const ImgLandmark& lm_in) {
   Landmark lm_out(lm_in.nID);
   lm_out.points.clear();
 
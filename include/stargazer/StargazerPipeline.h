@@ -0,0 +1,175 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LandmarkFinder.h"
+#include "Localizer.h"
+#include "StargazerImgTypes.h"
+#include "StargazerTypes.h"
+#include "internal/BoundedQueue.h"
+
+namespace stargazer {
+
+/**
+ * @brief Behaviour of a pipeline queue, when it is full
+ */
+enum struct QUEUE_POLICY {
+  DROP_OLDEST, /**< Discard the oldest element, keeps latency low */
+  BLOCK        /**< Wait for the next stage, no frame gets lost */
+};
+
+/**
+ * @brief Runs LandmarkFinder and Localizer in two threads, so that the landmarks of the next frame
+ * are detected while the pose of the current frame is optimized. The stages are connected by
+ * bounded lock-free queues:
+ *
+ *   Push -> [frames] -> detection -> [landmarks] -> localization -> [results] -> PopResult
+ *
+ * @remark The pipeline owns finder and localizer, they must not be used elsewhere meanwhile.
+ */
+class StargazerPipeline {
+ public:
+  /**
+   * @brief Result of a processed frame
+   */
+  struct Result {
+    uint64_t frame_id = 0;                /**< Number of the frame, as returned by Push */
+    pose_t pose = {{0., 0., 0., 0., 0., 0.}}; /**< Camera pose computed by the localizer */
+    std::vector<ImgLandmark> landmarks;   /**< Detected landmarks */
+  };
+
+  /**
+   * @brief Constructor. Starts the stage threads.
+   *
+   * @param finder Landmark finder of the detection stage
+   * @param localizer Localizer of the localization stage
+   * @param queue_size Capacity of each queue between the stages
+   * @param policy Behaviour of the queues, when a stage falls behind
+   */
+  StargazerPipeline(std::unique_ptr<LandmarkFinder> finder,
+                    std::unique_ptr<Localizer> localizer,
+                    size_t queue_size = 2,
+                    QUEUE_POLICY policy = QUEUE_POLICY::DROP_OLDEST);
+
+  /**
+   * @brief Destructor. Stops the pipeline.
+   */
+  ~StargazerPipeline();
+
+  StargazerPipeline(const StargazerPipeline&) = delete;
+  StargazerPipeline& operator=(const StargazerPipeline&) = delete;
+
+  /**
+   * @brief Hands a frame to the detection stage. With QUEUE_POLICY::BLOCK, it waits while the
+   * queue is full. Concurrent calls are serialized, so frame numbers follow the queue order.
+   * An invalid image fails the detection stage.
+   *
+   * @param img Camera image, it must not be modified until the frame has been processed
+   * @param dt Time since the last frame
+   * @return uint64_t Number of the frame
+   * @throws The exception of a failed stage, or std::runtime_error if the pipeline has been
+   * stopped. The frame has not been accepted then.
+   */
+  uint64_t Push(const cv::Mat& img, float dt);
+
+  /**
+   * @brief Takes the oldest result.
+   *
+   * @param result Output result
+   * @param wait Whether to wait for a result, if none is available
+   * @return bool False, if no result is available or the pipeline has been stopped
+   * @throws The exception of a failed stage
+   */
+  bool PopResult(Result& result, bool wait = true);
+
+  /**
+   * @brief Stops the stage threads. Frames in the queues are discarded.
+   */
+  void Stop();
+
+  /**
+   * @brief Number of frames and results discarded by QUEUE_POLICY::DROP_OLDEST so far
+   */
+  uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Frame {
+    uint64_t frame_id = 0;
+    cv::Mat img;
+    float dt = 0.f;
+  };
+
+  struct Detection {
+    uint64_t frame_id = 0;
+    std::vector<ImgLandmark> landmarks;
+    LandmarkMap::ConstPtr map;
+    float dt = 0.f;
+  };
+
+  std::unique_ptr<LandmarkFinder> finder_; /**< Detection stage, used by detection_thread_ only */
+  std::unique_ptr<Localizer> localizer_;   /**< Localization stage, used by localization_thread_ only */
+  QUEUE_POLICY policy_;                    /**< Behaviour of full queues */
+
+  BoundedQueue<Frame> frames_;         /**< Input of detection stage */
+  BoundedQueue<Detection> detections_; /**< Input of localization stage */
+  BoundedQueue<Result> results_;       /**< Output of localization stage */
+
+  std::atomic<bool> is_running_{true}; /**< Cleared to stop the threads */
+  std::mutex push_mutex_;       /**< Serializes Push, guards next_frame_id_ */
+  uint64_t next_frame_id_ = 0; /**< Number of the next accepted frame */
+  std::atomic<uint64_t> dropped_{0};
+
+  std::mutex error_mutex_;   /**< Guards error_ */
+  std::exception_ptr error_; /**< First exception thrown by a stage */
+
+  std::thread detection_thread_;
+  std::thread localization_thread_;
+
+  void RunDetection();
+  void RunLocalization();
+
+  /**
+   * @brief Appends to a queue according to the policy. The time in the queue is traced as
+   * interval of the given name, see Tracer::AsyncBegin.
+   *
+   * @return bool False, if the pipeline has been stopped while waiting
+   */
+  template <typename T>
+  bool Enqueue(BoundedQueue<T>& queue, T& value, const char* trace_name);
+
+  /**
+   * @brief Stores the exception of a failed stage and stops the pipeline
+   */
+  void Fail(std::exception_ptr error);
+
+  /**
+   * @brief Rethrows the exception of a failed stage
+   */
+  void RethrowError();
+};
+
+}  // namespace stargazer
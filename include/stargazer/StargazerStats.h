@@ -0,0 +1,67 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+namespace stargazer {
+
+/**
+ * @brief Durations and counts of a single LandmarkFinder::DetectLandmarks call. It is only
+ * filled, if it is set at the workspace. All durations are wall times in seconds.
+ */
+struct DetectionStats {
+  double grayscaleTime = 0.; /**< Conversion of the input image */
+  double blobTime = 0.;      /**< LandmarkFinder::FindBlobs */
+  double clusterTime = 0.;   /**< LandmarkFinder::FindClusters */
+  double cornerTime = 0.;    /**< LandmarkFinder::FindCorners for all clusters */
+  double idTime = 0.;        /**< ID decoding of all hypotheses */
+
+  uint32_t blobCount = 0;        /**< Points found */
+  uint32_t clusterCount = 0;     /**< Clusters within the point count limits */
+  uint64_t triplesEvaluated = 0; /**< Corner triples checked by LandmarkFinder::FindCorners */
+  uint32_t hypothesisCount = 0;  /**< Landmark hypotheses before ID decoding */
+  uint32_t forwardIdCount = 0;   /**< Hypotheses identified from their points */
+  uint32_t backwardIdCount = 0;  /**< Hypotheses identified by looking up the image */
+
+  /**
+   * @brief Sum of all stage durations
+   */
+  double getTotalTime() const { return grayscaleTime + blobTime + clusterTime + cornerTime + idTime; }
+};
+
+/**
+ * @brief Durations and counts of a single Localizer::UpdatePose call. It is only filled, if it is
+ * set at the localizer. All durations are wall times in seconds.
+ */
+struct LocalizationStats {
+  double residualTime = 0.; /**< Setup of the optimization problem */
+  double solveTime = 0.;    /**< Optimization */
+
+  uint32_t landmarkCount = 0;  /**< Landmarks the pose is based on */
+  uint32_t residualCount = 0;  /**< Residual blocks, one per landmark point */
+  uint32_t iterationCount = 0; /**< Solver iterations */
+
+  /**
+   * @brief Sum of all stage durations
+   */
+  double getTotalTime() const { return residualTime + solveTime; }
+};
+
+}  // namespace stargazer
@@ -18,7 +18,12 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <map>
+#include <stdexcept>
 #include <vector>
 
 namespace stargazer {
@@ -57,12 +62,195 @@ typedef std::array<double, (int)INTRINSICS::N_PARAMS> camera_params_t;
 typedef std::array<double, (int)POSE::N_PARAMS> pose_t;
 
 /**
- * @brief Point generator function for a given ID.
+ * @brief Covariance of a ::pose_t, row-major.
+ */
+typedef std::array<double, (int)POSE::N_PARAMS * (int)POSE::N_PARAMS> pose_covariance_t;
+
+/**
+ * @brief Vector with a fixed capacity, whose elements are stored inline. It never allocates and
+ * can be used in constant expressions. Copying it copies the elements only.
+ */
+template <typename T, size_t N>
+class FixedVector {
+ public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  constexpr FixedVector() : data_(), size_(0) {}
+  constexpr FixedVector(std::initializer_list<T> init) : data_(), size_(0) {
+    for (const T& el : init) {
+      push_back(el);
+    }
+  }
+
+  constexpr size_t size() const { return size_; }
+  constexpr bool empty() const { return size_ == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  constexpr T& operator[](size_t i) { return data_[i]; }
+  constexpr const T& operator[](size_t i) const { return data_[i]; }
+  constexpr T& front() { return data_[0]; }
+  constexpr const T& front() const { return data_[0]; }
+  constexpr T& back() { return data_[size_ - 1]; }
+  constexpr const T& back() const { return data_[size_ - 1]; }
+  constexpr T* data() { return data_.data(); }
+  constexpr const T* data() const { return data_.data(); }
+
+  constexpr iterator begin() { return data_.data(); }
+  constexpr iterator end() { return data_.data() + size_; }
+  constexpr const_iterator begin() const { return data_.data(); }
+  constexpr const_iterator end() const { return data_.data() + size_; }
+
+  constexpr void clear() { size_ = 0; }
+  constexpr void push_back(const T& el) {
+    if (size_ == N) {
+      throw std::length_error("FixedVector capacity exceeded");
+    }
+    data_[size_++] = el;
+  }
+  template <typename InputIt>
+  constexpr void assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+ private:
+  std::array<T, N> data_; /**< Element storage */
+  size_t size_;           /**< Number of valid elements */
+};
+
+/**
+ * @brief Landmark ID. It is wide enough for the IDs of every ::LandmarkFamily.
+ */
+typedef uint32_t landmark_id_t;
+
+constexpr double kLandmarkGridDistance = 0.08; /**< Distance between two adjacent landmark LEDs in meters */
+
+/**
+ * @brief Definition of the supported landmark layouts, see ::LandmarkFamily
+ */
+enum struct LANDMARK_FAMILY { GRID_4x4, GRID_5x5, GRID_6x6 };
+
+/**
+ * @brief Points of a landmark in landmark coordinates. The first three are the three corner points.
+ * It is large enough for landmarks of every ::LandmarkFamily.
+ */
+typedef FixedVector<Point, 35> landmark_points_t;
+
+/**
+ * @brief Compile time description of a landmark layout. The LandmarkFinder is instantiated for
+ * every family, so its inner loops run with constant grid sizes.
+ *
+ * A landmark is a square grid of GridCount x GridCount LEDs. Three of the four grid corners are
+ * always lit and define the landmark frame, the fourth one (x=0, y=GridCount-1) is always dark.
+ * All other LEDs encode the ID. The LED at grid position (x, y) contributes the bit
+ * x + GridCount * y, if all of these fit into IdType (Hagisonic layout). Otherwise the four corners
+ * are skipped while numbering, which makes a 6x6 grid fit into 32 bits.
+ *
+ * @tparam GridCount Number of rows and columns
+ * @tparam IdType Unsigned integer holding the ID
+ */
+template <int GridCount, typename IdType>
+struct LandmarkFamily {
+  typedef IdType id_type;
+
+  static constexpr int kGridCount = GridCount;        /**< Number of rows and columns */
+  static constexpr int kIdPointCount = GridCount * GridCount - 4; /**< Number of inner points */
+  static constexpr int kMaxPoints = 3 + kIdPointCount; /**< Corners and inner points */
+  static constexpr bool kSkipCorners = GridCount * GridCount > 8 * static_cast<int>(sizeof(IdType));
+
+  static_assert(GridCount >= 3, "A landmark needs at least three rows and columns");
+  static_assert(kIdPointCount <= 8 * static_cast<int>(sizeof(IdType)), "IdType is too small");
+  static_assert(kIdPointCount <= 8 * static_cast<int>(sizeof(landmark_id_t)),
+                "IDs do not fit into landmark_id_t");
+  static_assert(kMaxPoints <= static_cast<int>(landmark_points_t::capacity()),
+                "Points do not fit into landmark_points_t");
+
+  /**
+   * @brief Checks whether a grid position is one of the four corners
+   */
+  static constexpr bool isCorner(int x, int y) {
+    return (x == 0 || x == GridCount - 1) && (y == 0 || y == GridCount - 1);
+  }
+
+  /**
+   * @brief Getter for the bit of a grid position within the ID
+   *
+   * @param x Grid column
+   * @param y Grid row
+   * @return id_type Value of the LED at this position. Zero for corners, if they are skipped.
+   */
+  static constexpr id_type getBit(int x, int y) {
+    int bit = x + GridCount * y;
+    if (kSkipCorners) {
+      if (isCorner(x, y)) {
+        return 0;
+      }
+      // Subtract the number of corners preceding this position
+      bit -= (y == 0) ? 1 : (y == GridCount - 1) ? 3 : 2;
+    }
+    return static_cast<id_type>(id_type(1) << bit);
+  }
+
+  /**
+   * @brief Point generator function for a given ID. It does not allocate and can be evaluated at
+   * compile time.
+   *
+   * @param ID Landmark ID
+   * @return landmark_points_t List of points in landmark coordinates. The first three are the
+   * three corner points, followed by the ID points in ascending bit order.
+   */
+  static constexpr landmark_points_t getPoints(landmark_id_t ID) {
+    constexpr double lc = (GridCount - 1) * kLandmarkGridDistance;
+    landmark_points_t points = {{0., 0., 0.}, {lc, 0., 0.}, {lc, lc, 0.}};  // Corner points
+
+    // Add ID points
+    for (int y = 0; y < GridCount; y++) {    // For every column
+      for (int x = 0; x < GridCount; x++) {  // For every row
+        if (ID & getBit(x, y)) {
+          points.push_back({x * kLandmarkGridDistance, y * kLandmarkGridDistance, 0.});
+        }
+      }
+    }
+    return points;
+  }
+};
+
+typedef LandmarkFamily<4, uint16_t> LandmarkFamily4x4; /**< Hagisonic landmarks with 16 bit IDs */
+typedef LandmarkFamily<5, uint32_t> LandmarkFamily5x5; /**< 5x5 landmarks with 25 bit IDs */
+typedef LandmarkFamily<6, uint32_t> LandmarkFamily6x6; /**< 6x6 landmarks with 32 bit IDs */
+
+/**
+ * @brief Point generator function for a given ID of a 4x4 landmark. It can be evaluated at
+ * compile time.
  *
  * @param ID Landmark ID
- * @return std::vector<Point> List of points in landmark coordinates. The first three are the three corner points.
+ * @return landmark_points_t List of points in landmark coordinates. The first three are the three corner points.
  */
-std::vector<Point> getLandmarkPoints(int ID);  // Forward declaration
+constexpr landmark_points_t getLandmarkPoints(const landmark_id_t ID) {
+  return LandmarkFamily4x4::getPoints(ID);
+}
+
+/**
+ * @brief Point generator function for a given ID and landmark family.
+ *
+ * @param ID Landmark ID
+ * @param family Layout of the landmark
+ * @return landmark_points_t List of points in landmark coordinates. The first three are the three corner points.
+ */
+inline landmark_points_t getLandmarkPoints(const landmark_id_t ID, const LANDMARK_FAMILY family) {
+  switch (family) {
+    case LANDMARK_FAMILY::GRID_5x5:
+      return LandmarkFamily5x5::getPoints(ID);
+    case LANDMARK_FAMILY::GRID_6x6:
+      return LandmarkFamily6x6::getPoints(ID);
+    default:
+      return LandmarkFamily4x4::getPoints(ID);
+  }
+}
 
 /**
  * @brief This class resembles a map landmark. After construction with the id,
@@ -96,50 +284,30 @@ struct Landmark {
    * @brief Constructor
    *
    * @param ID
+   * @param family Layout of the landmark
    */
-  Landmark(int ID) : id(ID), points(getLandmarkPoints(ID)) {}
+  Landmark(landmark_id_t ID, LANDMARK_FAMILY family = LANDMARK_FAMILY::GRID_4x4)
+      : id(ID), points(getLandmarkPoints(ID, family)) {}
 
-  int id; /**< The landmarks id */
+  landmark_id_t id; /**< The landmarks id */
   std::array<double, static_cast<int>(POSE::N_PARAMS)> pose = {{0., 0., 0., 0., 0., 0.}}; /**< The landmarks pose */
-  std::vector<Point> points; /**< Vector of landmark points. The first three are the corners */
-  static constexpr int kGridCount = 4; /**< Number of rows and columns of a landmark */
+  landmark_points_t points; /**< Landmark points. The first three are the corners */
+  static constexpr int kGridCount = LandmarkFamily4x4::kGridCount; /**< Number of rows and columns of a 4x4 landmark */
   static constexpr double kGridDistance =
-      0.08; /**< Distance between two adjacent landmark LEDs in meters */
+      kLandmarkGridDistance; /**< Distance between two adjacent landmark LEDs in meters */
 };
 
-inline std::vector<Point> getLandmarkPoints(const int ID) {
-  std::vector<Point> points;
-
-  // Add corner points
-  const double lc(Landmark::kGridCount - 1);
-  points.push_back({0., 0., 0.});
-  points.push_back({lc, 0., 0.});
-  points.push_back({lc, lc, 0.});
-
-  // Add ID points
-  for (int y = 0; y < Landmark::kGridCount; y++)  // For every column
-  {
-    for (int x = 0; x < Landmark::kGridCount; x++) {  // For every row
-      /* StarLandmark IDs are coded: (here 4x4 grid)
-       * x steps are binary shifts by 1
-       * y steps are binary shifts by 4
-       */
-      if ((ID >> (Landmark::kGridCount * y + x)) & 1) {
-        points.push_back({static_cast<double>(x), static_cast<double>(y), 0.});
-      }
-    }
-  }
-  // Apply landmark scale
-  for (Point& p : points) {
-    p[static_cast<int>(POINT::X)] *= Landmark::kGridDistance;
-    p[static_cast<int>(POINT::Y)] *= Landmark::kGridDistance;
-  }
-  return points;
-}
-
 /**
  * @brief This class resembles the map representation. It holds a map of all known landmarks.
  */
-typedef std::map<int, Landmark> landmark_map_t;
+typedef std::map<landmark_id_t, Landmark> landmark_map_t;
+
+/**
+ * @brief Difference between two maps, e.g. after a partial recalibration
+ */
+struct LandmarkMapDelta {
+  landmark_map_t changed;             /**< Added and moved landmarks, in landmark coordinates */
+  std::vector<landmark_id_t> removed; /**< Ascending ids of removed landmarks */
+};
 
 }  // namespace stargazer
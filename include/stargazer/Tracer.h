@@ -0,0 +1,163 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stargazer {
+
+/**
+ * @brief Records begin and end events of the detection and localization stages and of the
+ * pipeline queues, and writes them as Chrome trace JSON. It can be opened with chrome://tracing
+ * or https://ui.perfetto.dev to see, where frames wait when detection and optimization overlap.
+ *
+ * Every thread writes into its own fixed-size buffer without locks. The recorded events are kept
+ * after their thread ended, so the trace can be written at any time, e.g. on exit. The unused
+ * part of the buffer is released then. Events that do not fit
+ * into a full buffer are counted and dropped. While tracing is disabled, recording an event costs
+ * a relaxed atomic load.
+ *
+ * @remark Event names are not copied, they have to be string literals or live until the trace
+ * has been written.
+ */
+class Tracer {
+ public:
+  /**
+   * @brief Starts recording. Previously recorded events are kept.
+   *
+   * @param events_per_thread Capacity of the buffer of every thread, applies to new threads only
+   */
+  static void Enable(size_t events_per_thread = 1 << 16);
+
+  /**
+   * @brief Stops recording
+   */
+  static void Disable();
+
+  /**
+   * @brief Whether events are recorded
+   */
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Names the calling thread in the trace
+   *
+   * @param name Thread name, e.g. "detection"
+   */
+  static void SetThreadName(const std::string& name);
+
+  /**
+   * @brief Records the begin of a stage on the calling thread
+   */
+  static void Begin(const char* name) {
+    if (isEnabled()) {
+      Record(name, 'B', 0);
+    }
+  }
+
+  /**
+   * @brief Records the end of the stage, that has been begun last on the calling thread
+   */
+  static void End(const char* name) {
+    if (isEnabled()) {
+      Record(name, 'E', 0);
+    }
+  }
+
+  /**
+   * @brief Records the begin of an interval, that may end on another thread, e.g. the time a
+   * frame spends in a queue
+   *
+   * @param name Name of the interval
+   * @param id Identifies the interval among those with the same name, e.g. the frame id
+   */
+  static void AsyncBegin(const char* name, uint64_t id) {
+    if (isEnabled()) {
+      Record(name, 'b', id);
+    }
+  }
+
+  /**
+   * @brief Records the end of an interval begun with Tracer::AsyncBegin
+   */
+  static void AsyncEnd(const char* name, uint64_t id) {
+    if (isEnabled()) {
+      Record(name, 'e', id);
+    }
+  }
+
+  /**
+   * @brief Writes all recorded events as Chrome trace JSON. Events recorded concurrently may or may
+   * not be included.
+   *
+   * @param tracefile Path of the trace file
+   * @throws std::runtime_error if the file can not be written
+   */
+  static void Write(const std::string& tracefile);
+
+  /**
+   * @brief Writes the trace when the process exits normally
+   *
+   * @param tracefile Path of the trace file
+   */
+  static void WriteOnExit(const std::string& tracefile);
+
+  /**
+   * @brief Getter for the number of events, that were dropped because of full buffers
+   */
+  static uint64_t getDroppedCount();
+
+ private:
+  friend class StageTimer;
+  friend class TraceScope;
+
+  static void Record(const char* name, char phase, uint64_t id);
+
+  static std::atomic<bool> enabled_; /**< Whether events are recorded */
+};
+
+/**
+ * @brief Records a stage for the lifetime of the scope. The end is recorded, whenever the begin
+ * has been, so stages stay balanced if tracing gets disabled meanwhile.
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name) : name_(Tracer::isEnabled() ? name : nullptr) {
+    if (name_) {
+      Tracer::Record(name_, 'B', 0);
+    }
+  }
+
+  ~TraceScope() {
+    if (name_) {
+      Tracer::Record(name_, 'E', 0);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name_; /**< Stage name, nullptr if the begin has not been recorded */
+};
+
+}  // namespace stargazer
@@ -0,0 +1,138 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LandmarkMap.h"
+#include "StargazerTypes.h"
+
+namespace stargazer {
+
+/**
+ * @brief Precomputed sets of landmark IDs per floor cell. For every cell, it holds the landmarks
+ * which may appear in the camera image from any camera position inside this cell and any
+ * orientation about the vertical axis. It is compiled offline for a map and camera, and used by
+ * the LandmarkFinder to check decoded IDs against the landmarks nearby only.
+ *
+ * @remark The table has to be recompiled, whenever the map or the camera changes. It stores the
+ * fingerprint of its map, so the LandmarkFinder ignores it for other maps, e.g. after an update
+ * has been published.
+ */
+class VisibilityTable {
+ public:
+  typedef std::shared_ptr<const VisibilityTable> ConstPtr;
+
+  /**
+   * @brief Range of ascending landmark IDs of a single cell
+   */
+  struct IdRange {
+    const landmark_id_t* first;
+    const landmark_id_t* last;
+    const landmark_id_t* begin() const { return first; }
+    const landmark_id_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+  };
+
+  /**
+   * @brief Constructor. Compiles the table.
+   *
+   * @param map Map of landmarks
+   * @param camera_intrinsics Camera parameters
+   * @param image_width Width of the camera image in pixels
+   * @param image_height Height of the camera image in pixels
+   * @param camera_height z coordinate of the camera in world coordinates
+   * @param cell_size Edge length of a floor cell in meters
+   * @param max_tilt Maximum deviation of the optical axis from the vertical (upwards) in radians
+   */
+  VisibilityTable(const LandmarkMap& map,
+                  const camera_params_t& camera_intrinsics,
+                  int image_width,
+                  int image_height,
+                  double camera_height,
+                  double cell_size = 1.0,
+                  double max_tilt = 0.1);
+
+  /**
+   * @brief Constructor. Reads a table written with ::writeVisibilityTable.
+   *
+   * @param tablefile Path to table file
+   * @throws std::runtime_error if the file can not be read or its cells are inconsistent
+   */
+  explicit VisibilityTable(const std::string& tablefile);
+
+  /**
+   * @brief Getter for the landmarks, which can be seen from a camera position
+   *
+   * @param x x coordinate of camera position in world coordinates
+   * @param y y coordinate of camera position in world coordinates
+   * @return IdRange Ascending IDs. Empty outside of the compiled area.
+   */
+  IdRange getVisibleIds(double x, double y) const;
+
+  /**
+   * @brief Whether a camera position lies within the compiled area
+   *
+   * @param x x coordinate of camera position in world coordinates
+   * @param y y coordinate of camera position in world coordinates
+   * @return bool False, if VisibilityTable::getVisibleIds is empty for lack of data
+   */
+  bool contains(double x, double y) const;
+
+  /**
+   * @brief Getter for the fingerprint of the map the table has been compiled for, see
+   * LandmarkMap::getFingerprint
+   *
+   * @return uint64_t
+   */
+  uint64_t getMapFingerprint() const { return map_fingerprint_; }
+
+ private:
+  friend void writeVisibilityTable(const std::string& tablefile, const VisibilityTable& table);
+
+  uint64_t map_fingerprint_ = 0; /**< Fingerprint of the compiled map */
+  double cell_size_ = 1.;  /**< Edge length of a cell */
+  double x_origin_ = 0.;   /**< x coordinate of the lower cell border */
+  double y_origin_ = 0.;   /**< y coordinate of the lower cell border */
+  int32_t cols_ = 0;       /**< Number of cells in x direction */
+  int32_t rows_ = 0;       /**< Number of cells in y direction */
+  std::vector<uint32_t> cell_offsets_;  /**< Start of every cell in cell_ids_, plus end marker */
+  std::vector<landmark_id_t> cell_ids_; /**< Landmark ids of all cells, concatenated */
+
+  /**
+   * @brief Computes the cell of a camera position
+   *
+   * @return bool False, if the position lies outside the compiled area
+   */
+  bool getCell(double x, double y, size_t& cell) const;
+};
+
+/**
+ * @brief Writes a visibility table to a binary file.
+ *
+ * @param tablefile Path of the table file
+ * @param table Compiled table
+ */
+void writeVisibilityTable(const std::string& tablefile, const VisibilityTable& table);
+
+}  // namespace stargazer
@@ -0,0 +1,165 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace stargazer {
+
+/**
+ * @brief Bounded lock-free queue for multiple producers and consumers (D. Vyukov's array queue).
+ * Every slot carries a sequence number, that tells producers and consumers whose turn it is, so
+ * neither side ever takes a lock.
+ *
+ * @tparam T Element type, has to be default constructible and movable
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param capacity Minimum number of elements. It gets rounded up to a power of two.
+   */
+  explicit BoundedQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @brief Number of elements the queue can hold
+   */
+  size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * @brief Whether the queue is empty. Only a snapshot, if other threads use the queue meanwhile.
+   */
+  bool empty() const {
+    const size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+  }
+
+  /**
+   * @brief Appends an element, if the queue is not full
+   *
+   * @param value Element, only moved from on success
+   * @return bool False, if the queue is full
+   */
+  bool TryPush(T& value) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // Full
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest element, if the queue is not empty
+   *
+   * @param value Output element
+   * @return bool False, if the queue is empty
+   */
+  bool TryPop(T& value) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // Empty
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->data);
+    cell->data = T();  // Release resources held by the element, e.g. image buffers
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence; /**< Turn of this slot, see BoundedQueue */
+    T data;                       /**< Element */
+  };
+
+  std::unique_ptr<Cell[]> cells_; /**< Ring buffer */
+  size_t mask_;                   /**< Capacity - 1 */
+  alignas(64) std::atomic<size_t> enqueue_pos_{0}; /**< Next slot to write */
+  alignas(64) std::atomic<size_t> dequeue_pos_{0}; /**< Next slot to read */
+};
+
+/**
+ * @brief Waiting strategy for threads polling a BoundedQueue. It spins first, then yields and
+ * finally sleeps for short periods, so idle stages do not occupy a core.
+ */
+class Backoff {
+ public:
+  void Wait() {
+    if (count_ < 64) {
+      count_++;
+    } else if (count_ < 128) {
+      count_++;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  void Reset() { count_ = 0; }
+
+ private:
+  int count_ = 0; /**< Number of unsuccessful polls */
+};
+
+}  // namespace stargazer
@@ -0,0 +1,492 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace stargazer {
+
+/**
+ * @brief Single pass reader for the small yaml subset used by the stargazer config files. It
+ * walks over the file contents without building a document tree and reports the line and column
+ * of every syntax error.
+ *
+ * Supported are block mappings, block sequences (also at the indentation of their key), flow
+ * mappings and sequences, comments and plain or quoted scalars. Mappings are handed to a key
+ * callback, which consumes the value with one of the Read functions and returns true, or returns
+ * false to skip it.
+ */
+class ConfigReader {
+ public:
+  /**
+   * @brief Constructor. Reads the whole file.
+   *
+   * @param cfgfile Path to config file
+   * @throws std::runtime_error if the file can not be read
+   */
+  explicit ConfigReader(const std::string& cfgfile) : cfgfile_(cfgfile) {
+    std::ifstream fin(cfgfile, std::ios::binary);
+    if (!fin) {
+      throw std::runtime_error("Stargazer config file does not exist: " + cfgfile);
+    }
+    std::ostringstream buffer;
+    buffer << fin.rdbuf();
+    data_ = buffer.str();
+  }
+
+  /**
+   * @brief Advances to the next top level key.
+   *
+   * @param key Output key
+   * @return bool False at the end of the file
+   */
+  bool NextSection(std::string_view& key) {
+    if (pos_ != 0) {
+      ExpectLineEnd();
+    }
+    size_t content;
+    const int indent = PeekLine(content);
+    if (indent < 0) {
+      return false;
+    }
+    pos_ = content;
+    if (indent != 0) {
+      Fail("Unexpected indentation");
+    }
+    key = ReadKey();
+    return true;
+  }
+
+  /**
+   * @brief Reads the mapping value of the current key.
+   *
+   * @param parent_indent Indentation of the current key
+   * @param key_fn Callback bool(std::string_view key), see ::ConfigReader
+   */
+  template <typename KeyFn>
+  void ReadMapping(int parent_indent, KeyFn&& key_fn) {
+    SkipSpaces();
+    if (Peek() == '{') {
+      ReadFlowMapping(key_fn);
+    } else if (AtLineEnd()) {
+      ReadNestedMapping(parent_indent, key_fn);
+    } else {
+      Fail("Expected mapping");
+    }
+  }
+
+  /**
+   * @brief Reads the sequence value of the current key. All items have to be mappings.
+   *
+   * @param parent_indent Indentation of the current key
+   * @param key_fn Callback bool(std::string_view key), see ::ConfigReader
+   * @param item_fn Callback void(size_t position), called after every item with its position
+   */
+  template <typename KeyFn, typename ItemFn>
+  void ReadSequence(int parent_indent, KeyFn&& key_fn, ItemFn&& item_fn) {
+    SkipSpaces();
+    if (Peek() == '[') {
+      Advance();
+      SkipFlowSpaces();
+      while (Peek() != ']') {
+        const size_t item = pos_;
+        ReadFlowMapping(key_fn);
+        item_fn(item);
+        SkipFlowSpaces();
+        if (Peek() == ',') {
+          Advance();
+          SkipFlowSpaces();
+        } else if (Peek() != ']') {
+          Fail("Expected ',' or ']'");
+        }
+      }
+      Advance();
+      return;
+    }
+    if (!AtLineEnd()) {
+      Fail("Expected sequence");
+    }
+
+    // Block sequences may be indented like their key
+    size_t content;
+    const int indent = PeekLine(content);
+    if (indent < parent_indent || data_[content] != '-') {
+      if (indent > parent_indent) {
+        pos_ = content;
+        Fail("Expected '-'");
+      }
+      return;  // Empty value
+    }
+    int next_indent = indent;
+    while (next_indent == indent && data_[content] == '-') {
+      pos_ = content;
+      const size_t item = pos_;
+      Advance();
+      if (!AtLineEnd() && Peek() != ' ' && Peek() != '\t') {
+        Fail("Expected ' ' after '-'");
+      }
+      SkipSpaces();
+      if (Peek() == '{') {
+        ReadFlowMapping(key_fn);
+      } else if (AtLineEnd()) {
+        ReadNestedMapping(indent, key_fn);
+      } else {
+        // Mapping starts on the line of the dash
+        ReadBlockMapping(Column(), key_fn);
+      }
+      item_fn(item);
+      ExpectLineEnd();
+      next_indent = PeekLine(content);
+    }
+    if (next_indent > indent) {
+      pos_ = content;
+      Fail(data_[content] == '-' ? "Unexpected indentation" : "Expected '-'");
+    }
+  }
+
+  /**
+   * @brief Reads a floating point value. Parsing is locale independent and exact for values
+   * written by ::ConfigWriter.
+   *
+   * @return double
+   */
+  double ReadDouble() {
+    const size_t begin = pos_;
+    const std::string_view token = ReadScalar();
+    // from_chars does not accept a leading '+'
+    const size_t offset = (token.size() > 1 && token[0] == '+' && token[1] != '-') ? 1 : 0;
+    double value = 0.;
+    const std::from_chars_result result =
+        std::from_chars(token.data() + offset, token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+      FailAt(begin, "Invalid number '" + std::string(token) + "'");
+    }
+    return value;
+  }
+
+  /**
+   * @brief Reads an unsigned integer value, either decimal or hexadecimal with a 0x prefix
+   *
+   * @return uint32_t
+   */
+  uint32_t ReadUnsigned() {
+    const size_t begin = pos_;
+    const std::string_view token = ReadScalar();
+    size_t offset = (!token.empty() && token[0] == '+') ? 1 : 0;
+    int base = 10;
+    if (token.substr(offset, 2) == "0x" || token.substr(offset, 2) == "0X") {
+      offset += 2;
+      base = 16;
+    }
+    uint32_t value = 0;
+    const std::from_chars_result result =
+        std::from_chars(token.data() + offset, token.data() + token.size(), value, base);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+      FailAt(begin, "Invalid unsigned integer '" + std::string(token) + "'");
+    }
+    return value;
+  }
+
+  /**
+   * @brief Skips the value of the current top level key
+   */
+  void SkipSection() { SkipValue(0); }
+
+  /**
+   * @brief Current position in the file, to report errors of the content later on
+   */
+  size_t getPosition() const { return pos_; }
+
+  /**
+   * @brief Throws an error with the current line and column
+   *
+   * @param msg Error description
+   */
+  [[noreturn]] void Fail(const std::string& msg) const { FailAt(pos_, msg); }
+
+  /**
+   * @brief Throws an error with the line and column of a position
+   *
+   * @param pos Position in the file, see ConfigReader::getPosition
+   * @param msg Error description
+   */
+  [[noreturn]] void FailAt(size_t pos, const std::string& msg) const {
+    int line = 1, column = 1;
+    for (size_t i = 0; i < pos && i < data_.size(); i++) {
+      if (data_[i] == '\n') {
+        line++;
+        column = 1;
+      } else {
+        column++;
+      }
+    }
+    throw std::runtime_error("Error in stargazer config file " + cfgfile_ + ":" +
+                             std::to_string(line) + ":" + std::to_string(column) + ": " + msg);
+  }
+
+ private:
+  std::string cfgfile_; /**< Path to config file, for error messages */
+  std::string data_;    /**< File contents */
+  size_t pos_ = 0;      /**< Current position in data_ */
+
+  char Peek() const { return pos_ < data_.size() ? data_[pos_] : '\0'; }
+  void Advance() { pos_++; }
+  bool AtEnd() const { return pos_ >= data_.size(); }
+
+  bool AtLineEnd() const {
+    const char c = Peek();
+    return c == '\0' || c == '\n' || c == '\r' || c == '#';
+  }
+
+  int Column() const {
+    const size_t line_begin = data_.rfind('\n', pos_ == 0 ? 0 : pos_ - 1);
+    return static_cast<int>(line_begin == std::string::npos ? pos_ : pos_ - line_begin - 1);
+  }
+
+  void SkipSpaces() {
+    while (Peek() == ' ' || Peek() == '\t') {
+      Advance();
+    }
+  }
+
+  void SkipComment() {
+    if (Peek() == '#') {
+      while (!AtEnd() && Peek() != '\n') {
+        Advance();
+      }
+    }
+  }
+
+  /**
+   * @brief Skips whitespace, newlines and comments within flow collections
+   */
+  void SkipFlowSpaces() {
+    while (true) {
+      const char c = Peek();
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        Advance();
+      } else if (c == '#') {
+        SkipComment();
+      } else {
+        return;
+      }
+    }
+  }
+
+  void ExpectLineEnd() {
+    SkipSpaces();
+    SkipComment();
+    if (Peek() == '\r') {
+      Advance();
+    }
+    if (!AtEnd() && Peek() != '\n') {
+      Fail("Unexpected content");
+    }
+  }
+
+  /**
+   * @brief Finds the next line with content, without moving
+   *
+   * @param content Output position of the first character of that line
+   * @return int Indentation of that line, -1 at the end of the file
+   */
+  int PeekLine(size_t& content) {
+    const size_t pos = pos_;
+    int indent = -1;
+    while (true) {
+      SkipSpaces();
+      SkipComment();
+      if (Peek() == '\r') {
+        Advance();
+      }
+      if (AtEnd()) {
+        break;
+      }
+      if (Peek() != '\n') {
+        indent = Column();
+        break;
+      }
+      Advance();
+    }
+    content = pos_;
+    pos_ = pos;
+    return indent;
+  }
+
+  std::string_view ReadScalar() {
+    const char quote = Peek();
+    if (quote == '"' || quote == '\'') {
+      const size_t begin = pos_;
+      const size_t end = data_.find(quote, begin + 1);
+      if (end == std::string::npos || data_.find('\n', begin) < end) {
+        Fail("Unterminated string");
+      }
+      pos_ = end + 1;
+      return std::string_view(data_).substr(begin + 1, end - begin - 1);
+    }
+    const size_t begin = pos_;
+    while (!AtEnd()) {
+      const char c = Peek();
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == '}' || c == ']' ||
+          c == '#') {
+        break;
+      }
+      Advance();
+    }
+    if (pos_ == begin) {
+      Fail("Expected value");
+    }
+    return std::string_view(data_).substr(begin, pos_ - begin);
+  }
+
+  /**
+   * @brief Reads a key and the following ':'
+   */
+  std::string_view ReadKey() {
+    const size_t begin = pos_;
+    while (!AtEnd()) {
+      const char c = Peek();
+      if (c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == '{' ||
+          c == '}' || c == '#') {
+        break;
+      }
+      Advance();
+    }
+    if (pos_ == begin) {
+      Fail("Expected key");
+    }
+    const std::string_view key = std::string_view(data_).substr(begin, pos_ - begin);
+    SkipSpaces();
+    if (Peek() != ':') {
+      Fail("Expected ':' after key '" + std::string(key) + "'");
+    }
+    Advance();
+    return key;
+  }
+
+  template <typename KeyFn>
+  void ReadValue(int indent, KeyFn& key_fn) {
+    const std::string_view key = ReadKey();
+    SkipSpaces();
+    if (!key_fn(key)) {
+      SkipValue(indent);
+    }
+  }
+
+  template <typename KeyFn>
+  void ReadFlowMapping(KeyFn& key_fn) {
+    if (Peek() != '{') {
+      Fail("Expected '{'");
+    }
+    Advance();
+    SkipFlowSpaces();
+    while (Peek() != '}') {
+      ReadValue(Column(), key_fn);
+      SkipFlowSpaces();
+      if (Peek() == ',') {
+        Advance();
+        SkipFlowSpaces();
+      } else if (Peek() != '}') {
+        Fail("Expected ',' or '}'");
+      }
+    }
+    Advance();
+  }
+
+  /**
+   * @brief Reads a block mapping, that starts on the next line
+   */
+  template <typename KeyFn>
+  void ReadNestedMapping(int parent_indent, KeyFn& key_fn) {
+    size_t content;
+    const int indent = PeekLine(content);
+    if (indent <= parent_indent) {
+      Fail("Expected mapping");
+    }
+    pos_ = content;
+    ReadBlockMapping(indent, key_fn);
+  }
+
+  /**
+   * @brief Reads a block mapping, whose first key is at the current position
+   */
+  template <typename KeyFn>
+  void ReadBlockMapping(int indent, KeyFn& key_fn) {
+    while (true) {
+      ReadValue(indent, key_fn);
+      ExpectLineEnd();
+      size_t content;
+      const int next_indent = PeekLine(content);
+      if (next_indent < indent || (next_indent == indent && data_[content] == '-')) {
+        return;
+      }
+      pos_ = content;
+      if (next_indent > indent) {
+        Fail("Unexpected indentation");
+      }
+    }
+  }
+
+  /**
+   * @brief Skips a scalar, a flow collection or a nested block of an unknown key
+   *
+   * @param indent Indentation of the key
+   */
+  void SkipValue(int indent) {
+    SkipSpaces();
+    if (Peek() == '{' || Peek() == '[') {
+      int depth = 0;
+      do {
+        const char c = Peek();
+        if (AtEnd()) {
+          Fail("Unterminated collection");
+        } else if (c == '{' || c == '[') {
+          depth++;
+        } else if (c == '}' || c == ']') {
+          depth--;
+        } else if (c == '#') {
+          SkipComment();
+          continue;
+        }
+        Advance();
+      } while (depth > 0);
+    } else if (!AtLineEnd()) {
+      ReadScalar();
+    } else {
+      // Nested block: every following line, that is indented deeper than the key
+      size_t content;
+      int next_indent;
+      while ((next_indent = PeekLine(content)) > indent ||
+             (next_indent == indent && data_[content] == '-')) {
+        pos_ = content;
+        while (!AtEnd() && Peek() != '\n' && Peek() != '\r') {
+          Advance();
+        }
+      }
+    }
+  }
+};
+
+}  // namespace stargazer
@@ -0,0 +1,84 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace stargazer {
+
+/**
+ * @brief Buffered writer for the stargazer config files. Numbers are formatted with
+ * std::to_chars, so doubles are written in their shortest form that reads back exactly,
+ * independent of the locale.
+ */
+class ConfigWriter {
+ public:
+  /**
+   * @brief Appends text
+   */
+  ConfigWriter& operator<<(std::string_view text) {
+    data_.append(text);
+    return *this;
+  }
+
+  /**
+   * @brief Appends a double in its shortest round-trip representation
+   */
+  ConfigWriter& operator<<(double value) {
+    char buffer[32];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    data_.append(buffer, result.ptr);
+    return *this;
+  }
+
+  /**
+   * @brief Appends an id as hexadecimal number with 0x prefix and at least four digits
+   */
+  void AppendHexId(uint32_t id) {
+    char buffer[16];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), id, 16);
+    data_.append("0x");
+    data_.append(result.ptr - buffer < 4 ? 4 - (result.ptr - buffer) : 0, '0');
+    data_.append(buffer, result.ptr);
+  }
+
+  /**
+   * @brief Writes the buffer to a file
+   *
+   * @param cfgfile Path to config file
+   * @throws std::runtime_error if the file can not be written
+   */
+  void Write(const std::string& cfgfile) const {
+    std::ofstream fout(cfgfile, std::ios::binary);
+    fout.write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    if (!fout) {
+      throw std::runtime_error("Could not write stargazer config file: " + cfgfile);
+    }
+  }
+
+ private:
+  std::string data_; /**< File contents */
+};
+
+}  // namespace stargazer
@@ -0,0 +1,123 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace stargazer {
+
+/**
+ * @brief Monotonic arena for the scratch data of a single frame. All memory is released at once
+ * by FrameArena::Reset. If a frame needed more than the arena holds, the overflow is taken from
+ * the heap and the arena grows to the peak demand at the next reset, so that in steady state no
+ * heap allocations happen.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param initial_size Size of the arena in bytes
+   */
+  explicit FrameArena(size_t initial_size = 64 * 1024) { Allocate(initial_size); }
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /**
+   * @brief Releases all memory handed out since the last reset. All containers using the arena
+   * have to be destroyed before.
+   */
+  void Reset() {
+    const size_t required = size_ + upstream_.getPeak();
+    resource_.reset();
+    upstream_.Clear();
+    if (required > size_) {
+      Allocate(required + required / 2);
+    } else {
+      resource_.emplace(buffer_.get(), size_, &upstream_);
+    }
+  }
+
+  /**
+   * @brief Getter for the memory resource, containers allocate from
+   *
+   * @return std::pmr::memory_resource*
+   */
+  std::pmr::memory_resource* getResource() { return &*resource_; }
+
+  /**
+   * @brief Getter for the size of the arena in bytes
+   */
+  size_t getSize() const { return size_; }
+
+  /**
+   * @brief Getter for the number of heap allocations since the last reset, 0 in steady state
+   */
+  size_t getOverflowCount() const { return upstream_.getCount(); }
+
+ private:
+  /**
+   * @brief Heap resource, that records the allocations the arena could not serve
+   */
+  class Upstream : public std::pmr::memory_resource {
+   public:
+    size_t getPeak() const { return peak_; }
+    size_t getCount() const { return count_; }
+    void Clear() { bytes_ = peak_ = count_ = 0; }
+
+   private:
+    size_t bytes_ = 0; /**< Bytes currently taken from the heap */
+    size_t peak_ = 0;  /**< Maximum of bytes_ since the last reset */
+    size_t count_ = 0; /**< Number of heap allocations since the last reset */
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      bytes_ += bytes;
+      peak_ = std::max(peak_, bytes_);
+      count_++;
+      return p;
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      bytes_ -= bytes;
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  std::unique_ptr<std::byte[]> buffer_; /**< Memory of the arena */
+  size_t size_ = 0;                     /**< Size of buffer_ */
+  Upstream upstream_;                   /**< Fallback for allocations exceeding the arena */
+  std::optional<std::pmr::monotonic_buffer_resource> resource_; /**< Hands out buffer_ */
+
+  void Allocate(size_t size) {
+    resource_.reset();
+    buffer_.reset(new std::byte[size]);
+    size_ = size;
+    resource_.emplace(buffer_.get(), size_, &upstream_);
+  }
+};
+
+}  // namespace stargazer
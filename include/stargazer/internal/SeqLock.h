@@ -0,0 +1,115 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace stargazer {
+
+/**
+ * @brief Sequence lock for a single writer and any number of readers. The writer never waits,
+ * readers never block the writer and detect torn reads by the sequence number, which is odd while
+ * a write is in progress. The value is held in atomic words, so it may live in shared memory and
+ * be read by other processes.
+ *
+ * @tparam T Value type, has to be trivially copyable
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock values have to be trivially copyable");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "SeqLock needs lock-free 64 bit atomics");
+
+ public:
+  SeqLock() {
+    for (auto& word : words_) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  /**
+   * @brief Replaces the value. Must not be called concurrently.
+   */
+  void Store(const T& value) {
+    uint64_t buffer[kWords] = {};
+    std::memcpy(buffer, &value, sizeof(T));
+    const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Reads the value with a single attempt. Wait-free.
+   *
+   * @param value Output value, only written on success
+   * @return bool False, if a write was in progress
+   */
+  bool TryLoad(T& value) const {
+    const uint64_t before = sequence_.load(std::memory_order_acquire);
+    if (before & 1) {
+      return false;
+    }
+    uint64_t buffer[kWords];
+    for (size_t i = 0; i < kWords; i++) {
+      buffer[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != before) {
+      return false;
+    }
+    std::memcpy(&value, buffer, sizeof(T));
+    return true;
+  }
+
+  /**
+   * @brief Reads the value, retrying while the writer interferes. Lock-free.
+   *
+   * @return T
+   */
+  T Load() const {
+    T value;
+    while (!TryLoad(value)) {
+      std::this_thread::yield();
+    }
+    return value;
+  }
+
+  /**
+   * @brief Getter for the number of completed writes
+   */
+  uint64_t getVersion() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence_{0}; /**< Twice the number of writes, plus one during a write */
+  std::atomic<uint64_t> words_[kWords]; /**< Value */
+};
+
+}  // namespace stargazer
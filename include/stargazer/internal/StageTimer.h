@@ -0,0 +1,83 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+
+#include "Tracer.h"
+
+namespace stargazer {
+
+/**
+ * @brief Adds the wall time of a scope to a field of a stats struct, e.g. DetectionStats, and
+ * records the scope as stage in the Tracer. Without stats and tracing it does not even read the
+ * clock, so instrumented code costs a branch when disabled.
+ */
+class StageTimer {
+ public:
+  /**
+   * @brief Constructor. Starts the timer.
+   *
+   * @param stats Stats struct, may be nullptr
+   * @param duration Field of the stats, the duration in seconds is added to
+   * @param trace_name Stage name in the trace, a string literal
+   */
+  template <typename Stats>
+  StageTimer(Stats* stats, double Stats::*duration, const char* trace_name)
+      : duration_(stats ? &(stats->*duration) : nullptr),
+        trace_name_(Tracer::isEnabled() ? trace_name : nullptr) {
+    if (duration_) {
+      start_ = clock::now();
+    }
+    if (trace_name_) {
+      Tracer::Record(trace_name_, 'B', 0);
+    }
+  }
+
+  /**
+   * @brief Destructor. Stops the timer, if StageTimer::Stop has not been called.
+   */
+  ~StageTimer() { Stop(); }
+
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+
+  /**
+   * @brief Stops the timer and adds the elapsed time
+   */
+  void Stop() {
+    if (duration_) {
+      *duration_ += std::chrono::duration<double>(clock::now() - start_).count();
+      duration_ = nullptr;
+    }
+    if (trace_name_) {
+      Tracer::Record(trace_name_, 'E', 0);
+      trace_name_ = nullptr;
+    }
+  }
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  double* duration_;        /**< Receiver of the duration, nullptr if disabled or stopped */
+  const char* trace_name_;  /**< Stage name, nullptr if not traced or stopped */
+  clock::time_point start_; /**< Start of the scope */
+};
+
+}  // namespace stargazer
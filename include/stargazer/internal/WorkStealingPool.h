@@ -0,0 +1,183 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace stargazer {
+
+/**
+ * @brief Thread pool with one task queue per worker. Tasks submitted by a worker go to its own
+ * queue, all others are distributed round-robin. Idle workers steal from the queues of the
+ * others, so the load is balanced over all threads. Both owners and thieves take the oldest task
+ * first, so tasks run roughly in submission order.
+ */
+class WorkStealingPool {
+ public:
+  typedef std::function<void()> Task;
+
+  /**
+   * @brief Constructor. Starts the worker threads.
+   *
+   * @param thread_count Number of worker threads (at least one)
+   */
+  explicit WorkStealingPool(size_t thread_count = std::thread::hardware_concurrency()) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    for (size_t i = 0; i < thread_count; i++) {
+      workers_.emplace_back(new Worker);
+    }
+    for (size_t i = 0; i < thread_count; i++) {
+      threads_.emplace_back(&WorkStealingPool::Run, this, i);
+    }
+  }
+
+  /**
+   * @brief Destructor. Stops the pool.
+   */
+  ~WorkStealingPool() { Stop(); }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * @brief Schedules a task. Tasks must not throw.
+   *
+   * @param task Task to run on one of the workers
+   * @throws std::runtime_error If the pool has been stopped
+   */
+  void Submit(Task task) {
+    if (!TrySubmit(std::move(task))) {
+      throw std::runtime_error("WorkStealingPool has been stopped");
+    }
+  }
+
+  /**
+   * @brief Schedules a task, unless the pool has been stopped. Tasks must not throw.
+   *
+   * @param task Task to run on one of the workers
+   * @return bool Whether the task has been queued
+   */
+  bool TrySubmit(Task task) {
+    const size_t index = current_pool_ == this ? current_worker_
+                                               : next_worker_.fetch_add(1) % workers_.size();
+    {
+      // Checked under the queue lock, so Stop either rejects the task or discards it
+      std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+      if (!is_running_.load()) {
+        return false;
+      }
+      workers_[index]->tasks.push_back(std::move(task));
+      pending_.fetch_add(1);
+    }
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }  // Worker is either asleep or sees pending_
+    wakeup_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Waits for the running tasks and stops the workers. Queued tasks are discarded and
+   * further submits are rejected.
+   */
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      is_running_.store(false);
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      pending_.fetch_sub(worker->tasks.size());
+      worker->tasks.clear();
+    }
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  /**
+   * @brief Getter for the number of worker threads
+   */
+  size_t getThreadCount() const { return workers_.size(); }
+
+  /**
+   * @brief Whether the pool accepts tasks, i.e. it has not been stopped yet
+   */
+  bool isRunning() const { return is_running_.load(); }
+
+ private:
+  struct Worker {
+    std::mutex mutex;       /**< Guards tasks */
+    std::deque<Task> tasks; /**< Queued tasks, oldest first */
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_; /**< Task queue of every worker */
+  std::vector<std::thread> threads_;             /**< Worker threads */
+  std::atomic<size_t> next_worker_{0};           /**< Round-robin counter for external submits */
+  std::atomic<size_t> pending_{0};               /**< Number of queued tasks */
+  std::mutex sleep_mutex_;                       /**< Held while clearing is_running_, used for wakeup_ */
+  std::condition_variable wakeup_;               /**< Notified on new tasks and on stop */
+  std::atomic<bool> is_running_{true};           /**< Cleared by Stop */
+
+  inline static thread_local const WorkStealingPool* current_pool_ = nullptr; /**< Pool of this thread */
+  inline static thread_local size_t current_worker_ = 0; /**< Worker index of this thread */
+
+  bool Take(size_t index, Task& task) {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    if (workers_[index]->tasks.empty()) {
+      return false;
+    }
+    task = std::move(workers_[index]->tasks.front());
+    workers_[index]->tasks.pop_front();
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  void Run(size_t index) {
+    current_pool_ = this;
+    current_worker_ = index;
+    Task task;
+    while (is_running_.load()) {
+      // Own queue first, then steal from the others
+      bool has_task = false;
+      for (size_t i = 0; i < workers_.size() && !has_task; i++) {
+        has_task = Take((index + i) % workers_.size(), task);
+      }
+      if (has_task) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wakeup_.wait(lock, [this]() { return pending_.load() > 0 || !is_running_.load(); });
+    }
+  }
+};
+
+}  // namespace stargazer
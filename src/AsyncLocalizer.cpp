@@ -0,0 +1,143 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "AsyncLocalizer.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+using namespace stargazer;
+
+AsyncLocalizer::AsyncLocalizer(std::unique_ptr<Localizer> localizer,
+                               std::unique_ptr<LandmarkFinder> finder,
+                               bool compute_covariance)
+    : localizer_(std::move(localizer)),
+      finder_(std::move(finder)),
+      compute_covariance_(compute_covariance) {
+  if (!localizer_) {
+    throw std::invalid_argument("AsyncLocalizer needs a Localizer");
+  }
+}
+
+AsyncLocalizer::~AsyncLocalizer() { executor_.Stop(); }
+
+std::future<PoseResult> AsyncLocalizer::UpdatePose(std::vector<ImgLandmark> img_landmarks, float dt) {
+  auto landmarks = std::make_shared<std::vector<ImgLandmark>>(std::move(img_landmarks));
+  return Submit([this, landmarks, dt]() { return Run(nullptr, *landmarks, dt); });
+}
+
+void AsyncLocalizer::UpdatePose(std::vector<ImgLandmark> img_landmarks, float dt, Callback callback) {
+  auto landmarks = std::make_shared<std::vector<ImgLandmark>>(std::move(img_landmarks));
+  Submit([this, landmarks, dt]() { return Run(nullptr, *landmarks, dt); }, std::move(callback));
+}
+
+std::future<PoseResult> AsyncLocalizer::Localize(const cv::Mat& img, float dt) {
+  if (!finder_) {
+    throw std::runtime_error("AsyncLocalizer has no LandmarkFinder to localize images");
+  }
+  return Submit([this, img, dt]() {
+    std::vector<ImgLandmark> img_landmarks;
+    return Run(&img, img_landmarks, dt);
+  });
+}
+
+void AsyncLocalizer::Localize(const cv::Mat& img, float dt, Callback callback) {
+  if (!finder_) {
+    throw std::runtime_error("AsyncLocalizer has no LandmarkFinder to localize images");
+  }
+  Submit(
+      [this, img, dt]() {
+        std::vector<ImgLandmark> img_landmarks;
+        return Run(&img, img_landmarks, dt);
+      },
+      std::move(callback));
+}
+
+PoseResult AsyncLocalizer::getLastResult() const {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  return last_result_;
+}
+
+PoseResult AsyncLocalizer::Run(const cv::Mat* img, std::vector<ImgLandmark>& img_landmarks, float dt) {
+  typedef std::chrono::steady_clock clock;
+  PoseResult result;
+
+  const clock::time_point start = clock::now();
+  LandmarkMap::ConstPtr map;
+  if (img) {
+    // Ends up in the future or callback of the request
+    if (finder_->DetectLandmarks(*img, img_landmarks) < 0) {
+      throw std::runtime_error("AsyncLocalizer could not detect landmarks: invalid image");
+    }
+    map = finder_->getMap();
+  }
+  const clock::time_point detected = clock::now();
+  localizer_->UpdatePose(img_landmarks, dt, std::move(map));
+  result.pose = localizer_->getPose();
+  if (compute_covariance_) {
+    result.has_covariance = localizer_->ComputePoseCovariance(result.covariance);
+  }
+  const clock::time_point solved = clock::now();
+
+  result.landmark_count = img_landmarks.size();
+  result.detection_time = std::chrono::duration<double>(detected - start).count();
+  result.solve_time = std::chrono::duration<double>(solved - detected).count();
+  {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    last_result_ = result;
+  }
+  return result;
+}
+
+void AsyncLocalizer::Submit(std::function<PoseResult()> request, Callback callback) {
+  executor_.Submit([request = std::move(request), callback = std::move(callback)]() {
+    PoseResult result;
+    std::exception_ptr error;
+    try {
+      result = request();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (!callback) {
+      return;
+    }
+    // The executor must not throw, so errors of the callback end here
+    try {
+      callback(result, error);
+    } catch (const std::exception& e) {
+      std::cerr << "AsyncLocalizer callback threw: " << e.what() << std::endl;
+    } catch (...) {
+      std::cerr << "AsyncLocalizer callback threw an unknown exception" << std::endl;
+    }
+  });
+}
+
+std::future<PoseResult> AsyncLocalizer::Submit(std::function<PoseResult()> request) {
+  // std::function needs copyable targets, so the promise is shared
+  auto promise = std::make_shared<std::promise<PoseResult>>();
+  std::future<PoseResult> future = promise->get_future();
+  executor_.Submit([request = std::move(request), promise]() {
+    try {
+      promise->set_value(request());
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return future;
+}
@@ -0,0 +1,188 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "BinaryMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CoordinateTransformations.h"
+#include "StargazerConfig.h"
+
+using namespace stargazer;
+
+namespace {
+
+/// Whether count elements starting at offset fit into a file of the given length, without overflow
+bool sectionFits(uint64_t offset, uint64_t count, size_t element_size, size_t length) {
+  return offset <= length && count <= (length - offset) / element_size;
+}
+
+}  // namespace
+
+BinaryMap::BinaryMap(const std::string& mapfile) {
+  const int fd = ::open(mapfile.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Stargazer binary map file does not exist: " + mapfile);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BinaryMapHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Stargazer binary map file is truncated: " + mapfile);
+  }
+  length_ = static_cast<size_t>(st.st_size);
+  data_ = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // The mapping stays valid after closing the descriptor
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error("Could not map stargazer binary map file: " + mapfile);
+  }
+
+  /// Validate header and section bounds, everything else is used as is
+  const char* base = static_cast<const char*>(data_);
+  header_ = reinterpret_cast<const BinaryMapHeader*>(base);
+  std::string error;
+  if (std::memcmp(header_->magic, kBinaryMapMagic, sizeof(kBinaryMapMagic)) != 0) {
+    error = "Stargazer binary map file has wrong signature: ";
+  } else if (header_->version != kBinaryMapVersion) {
+    error = "Stargazer binary map file has unsupported version " +
+            std::to_string(header_->version) + ": ";
+  } else if (header_->family > static_cast<uint32_t>(LANDMARK_FAMILY::GRID_6x6)) {
+    error = "Stargazer binary map file has unknown landmark family " +
+            std::to_string(header_->family) + ": ";
+  } else if (!sectionFits(header_->landmarks_offset,
+                          header_->landmark_count,
+                          sizeof(BinaryMapLandmark),
+                          length_) ||
+             !sectionFits(header_->points_offset, header_->point_count, sizeof(Point), length_) ||
+             header_->landmarks_offset % alignof(BinaryMapLandmark) != 0 ||
+             header_->points_offset % alignof(Point) != 0) {
+    error = "Stargazer binary map file is corrupt: ";
+  } else {
+    /// Point ranges are handed out unchecked by getWorldPoints and find relies on the sort order
+    landmarks_ = reinterpret_cast<const BinaryMapLandmark*>(base + header_->landmarks_offset);
+    for (size_t i = 0; i < header_->landmark_count; i++) {
+      const BinaryMapLandmark& lm = landmarks_[i];
+      if (lm.first_point > header_->point_count ||
+          lm.point_count > header_->point_count - lm.first_point ||
+          (i > 0 && landmarks_[i - 1].id >= lm.id)) {
+        error = "Stargazer binary map file is corrupt: ";
+        break;
+      }
+    }
+  }
+  if (!error.empty()) {
+    ::munmap(data_, length_);
+    data_ = nullptr;
+    throw std::runtime_error(error + mapfile);
+  }
+  points_ = reinterpret_cast<const Point*>(base + header_->points_offset);
+}
+
+BinaryMap::~BinaryMap() {
+  if (data_) {
+    ::munmap(data_, length_);
+  }
+}
+
+const BinaryMapLandmark* BinaryMap::find(landmark_id_t id) const {
+  const BinaryMapLandmark* it =
+      std::lower_bound(begin(), end(), id, [](const BinaryMapLandmark& lm, landmark_id_t id) {
+        return lm.id < id;
+      });
+  return (it != end() && it->id == id) ? it : nullptr;
+}
+
+void BinaryMap::toLandmarkMap(landmark_map_t& landmarks) const {
+  const LANDMARK_FAMILY family = getFamily();
+  for (const BinaryMapLandmark& lm : *this) {
+    Landmark& landmark = landmarks[lm.id] = Landmark(lm.id, family);
+    std::copy(std::begin(lm.pose), std::end(lm.pose), landmark.pose.begin());
+  }
+}
+
+void stargazer::writeBinaryMap(const std::string& mapfile,
+                               const landmark_map_t& landmarks,
+                               LANDMARK_FAMILY family) {
+  std::vector<BinaryMapLandmark> records;
+  std::vector<Point> points;
+  records.reserve(landmarks.size());
+
+  // landmark_map_t is ordered, so the records end up sorted by id
+  for (auto& el : landmarks) {
+    BinaryMapLandmark record;
+    record.id = el.first;
+    record.point_count = static_cast<uint32_t>(el.second.points.size());
+    record.first_point = points.size();
+    std::copy(el.second.pose.begin(), el.second.pose.end(), record.pose);
+    records.push_back(record);
+
+    for (auto& pt : el.second.points) {
+      double x, y, z;
+      transformLandMarkToWorld(
+          pt[(int)POINT::X], pt[(int)POINT::Y], el.second.pose.data(), &x, &y, &z);
+      points.push_back({x, y, z});
+    }
+  }
+
+  BinaryMapHeader header;
+  std::memcpy(header.magic, kBinaryMapMagic, sizeof(kBinaryMapMagic));
+  header.version = kBinaryMapVersion;
+  header.landmark_count = static_cast<uint32_t>(records.size());
+  header.point_count = points.size();
+  header.landmarks_offset = sizeof(BinaryMapHeader);
+  header.points_offset = header.landmarks_offset + records.size() * sizeof(BinaryMapLandmark);
+  header.family = static_cast<uint32_t>(family);
+  header.reserved = 0;
+
+  std::ofstream fout(mapfile, std::ios::binary);
+  if (!fout) {
+    throw std::runtime_error("Could not open stargazer binary map file for writing: " + mapfile);
+  }
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(reinterpret_cast<const char*>(records.data()),
+             records.size() * sizeof(BinaryMapLandmark));
+  fout.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(Point));
+  fout.close();
+}
+
+void stargazer::readBinaryMap(const std::string& mapfile, landmark_map_t& landmarks) {
+  BinaryMap(mapfile).toLandmarkMap(landmarks);
+}
+
+void stargazer::convertMapConfigToBinary(const std::string& cfgfile,
+                                         const std::string& mapfile,
+                                         LANDMARK_FAMILY family) {
+  landmark_map_t landmarks;
+  readMapConfig(cfgfile, landmarks, family);
+  writeBinaryMap(mapfile, landmarks, family);
+}
+
+void stargazer::convertBinaryToMapConfig(const std::string& mapfile, const std::string& cfgfile) {
+  landmark_map_t landmarks;
+  readBinaryMap(mapfile, landmarks);
+  writeMapConfig(cfgfile, landmarks);
+}
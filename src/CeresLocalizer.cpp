@@ -23,47 +23,69 @@
 #include <ceres/ceres.h>
 
 #include "internal/CostFunction.h"
+#include "internal/StageTimer.h"
 
 using namespace stargazer;
 
 CeresLocalizer::CeresLocalizer(const std::string& cam_cfgfile,
                                const std::string& map_cfgfile,
                                bool estimate_2d_pose)
-    : Localizer(cam_cfgfile, map_cfgfile),
+    : CeresLocalizer(cam_cfgfile, std::make_shared<const LandmarkMap>(map_cfgfile), estimate_2d_pose) {}
+
+CeresLocalizer::CeresLocalizer(const std::string& cam_cfgfile,
+                               LandmarkMap::ConstPtr map,
+                               bool estimate_2d_pose)
+    : CeresLocalizer(cam_cfgfile, std::make_shared<LandmarkMapHandle>(std::move(map)), estimate_2d_pose) {}
+
+CeresLocalizer::CeresLocalizer(const std::string& cam_cfgfile,
+                               LandmarkMapHandle::Ptr map_handle,
+                               bool estimate_2d_pose)
+    : Localizer(cam_cfgfile, std::move(map_handle)),
       estimate_2d_pose(estimate_2d_pose),
-      z_upper_bound(std::numeric_limits<double>::max()) {
-
-  // Convert landmark points to worldcoordinates once.
-  for (auto& el : landmarks) {
-    for (auto& pt : el.second.points) {
-      double x, y, z;
-      transformLandMarkToWorld(
-          pt[(int)POINT::X], pt[(int)POINT::Y], el.second.pose.data(), &x, &y, &z);
-      pt = {x, y, z};
-      z_upper_bound = std::min(z_upper_bound, z);
-    }
-  }
-  z_upper_bound -= 1.;  // Assumption: Camera is at least 1m below the stargazer landmarks
+      // Assumption: Camera is at least 1m below the stargazer landmarks
+      z_upper_bound(map_->getMinHeight() - 1.) {
 
   is_initialized = false;
 }
 
 void CeresLocalizer::UpdatePose(std::vector<ImgLandmark>& img_landmarks, float dt) {
+  TraceScope trace("UpdatePose");
+
+  if (UpdateMap()) {
+    z_upper_bound = map_->getMinHeight() - 1.;
+  }
+  is_solved = false;
+  if (stats_) {
+    *stats_ = LocalizationStats();
+    stats_->landmarkCount = static_cast<uint32_t>(img_landmarks.size());
+  }
+
   if (img_landmarks.empty()) {
     std::cout << "Localizer received empty landmarks vector" << std::endl;
     return;
   }
 
+  const landmark_map_t& landmarks = map_->getWorldLandmarks();
+
   if (!is_initialized) {
+    size_t known_count = 0;
     for (auto& el : img_landmarks) {
-      ego_pose[(int)POSE::X] += landmarks[el.nID].pose[(int)POSE::X];
-      ego_pose[(int)POSE::Y] += landmarks[el.nID].pose[(int)POSE::Y];
+      auto lm = landmarks.find(el.nID);
+      if (lm != landmarks.end()) {
+        ego_pose[(int)POSE::X] += lm->second.pose[(int)POSE::X];
+        ego_pose[(int)POSE::Y] += lm->second.pose[(int)POSE::Y];
+        known_count++;
+      }
+    }
+    if (known_count > 0) {
+      ego_pose[(int)POSE::X] /= known_count;
+      ego_pose[(int)POSE::Y] /= known_count;
     }
-    ego_pose[(int)POSE::X] /= img_landmarks.size();
-    ego_pose[(int)POSE::Y] /= img_landmarks.size();
     // is_initialized = true;
   }
 
+  StageTimer residual_timer(stats_, &LocalizationStats::residualTime, "AddResidualBlocks");
+
   // Delete old data
   ClearResidualBlocks();
 
@@ -74,9 +96,21 @@ void CeresLocalizer::UpdatePose(std::vector<ImgLandmark>& img_landmarks, float d
   // Assumes that camera is approximately looking into positive z direction (map)
   if (problem.HasParameterBlock(ego_pose.data()))
     problem.SetParameterUpperBound(ego_pose.data(), (int)POSE::Z, z_upper_bound);
+  residual_timer.Stop();
 
   // Optimize
-  Optimize();
+  {
+    StageTimer timer(stats_, &LocalizationStats::solveTime, "Optimize");
+    Optimize();
+  }
+  // Residual blocks of known landmarks only, the problem keeps its parameter blocks when empty
+  is_solved = problem.NumResidualBlocks() > 0 && summary.IsSolutionUsable();
+  if (stats_) {
+    stats_->residualCount = static_cast<uint32_t>(problem.NumResidualBlocks());
+    stats_->iterationCount = static_cast<uint32_t>(summary.iterations.size());
+  }
+
+  PublishPose();
 }
 
 void CeresLocalizer::ClearResidualBlocks() {
@@ -87,35 +121,42 @@ void CeresLocalizer::ClearResidualBlocks() {
   }
 }
 
-void CeresLocalizer::AddResidualBlocks(std::vector<ImgLandmark> img_landmarks) {
+void CeresLocalizer::AddResidualBlocks(const std::vector<ImgLandmark>& img_landmarks) {
+  const landmark_map_t& landmarks = map_->getWorldLandmarks();
+
   for (auto& img_lm : img_landmarks) {
+    // Landmarks detected on an older map may have been removed since
+    auto it = landmarks.find(img_lm.nID);
+    if (it == landmarks.end()) {
+      continue;
+    }
+    const Landmark& lm = it->second;
 
-    if (img_lm.idPoints.size() + img_lm.corners.size() !=
-        landmarks[img_lm.nID].points.size()) {
+    if (img_lm.idPoints.size() + img_lm.corners.size() != lm.points.size()) {
       std::cerr << "point count does not match! "
                 << img_lm.idPoints.size() + img_lm.corners.size()
-                << "(observed) vs. " << landmarks[img_lm.nID].points.size()
+                << "(observed) vs. " << lm.points.size()
                 << "(map)\t ID: " << img_lm.nID << std::endl;
       return;
     };
 
     // Add residual block, for every one of the seen points.
-    for (size_t k = 0; k < landmarks[img_lm.nID].points.size(); k++) {
+    for (size_t k = 0; k < lm.points.size(); k++) {
       ceres::CostFunction* cost_function;
       if (k < 3) {
         cost_function = WorldToImageReprojectionFunctor::Create(
             img_lm.corners[k].x,
             img_lm.corners[k].y,
-            landmarks[img_lm.nID].points[k][(int)POINT::X],
-            landmarks[img_lm.nID].points[k][(int)POINT::Y],
-            landmarks[img_lm.nID].points[k][(int)POINT::Z]);
+            lm.points[k][(int)POINT::X],
+            lm.points[k][(int)POINT::Y],
+            lm.points[k][(int)POINT::Z]);
       } else {
         cost_function = WorldToImageReprojectionFunctor::Create(
             img_lm.idPoints[k - 3].x,
             img_lm.idPoints[k - 3].y,
-            landmarks[img_lm.nID].points[k][(int)POINT::X],
-            landmarks[img_lm.nID].points[k][(int)POINT::Y],
-            landmarks[img_lm.nID].points[k][(int)POINT::Z]);
+            lm.points[k][(int)POINT::X],
+            lm.points[k][(int)POINT::Y],
+            lm.points[k][(int)POINT::Z]);
       }
       // CauchyLoss(9): a pixel-error of 3 is still considered as inlayer
       problem.AddResidualBlock(cost_function,
@@ -140,6 +181,20 @@ void CeresLocalizer::AddResidualBlocks(std::vector<ImgLandmark> img_landmarks) {
   SetCameraParamsConstant();
 }
 
+bool CeresLocalizer::ComputePoseCovariance(pose_covariance_t& covariance) {
+  if (!is_solved || !problem.HasParameterBlock(ego_pose.data())) {
+    return false;
+  }
+  ceres::Covariance::Options options;
+  ceres::Covariance estimator(options);
+  const std::vector<std::pair<const double*, const double*>> blocks = {
+      {ego_pose.data(), ego_pose.data()}};
+  if (!estimator.Compute(blocks, &problem)) {
+    return false;
+  }
+  return estimator.GetCovarianceBlock(ego_pose.data(), ego_pose.data(), covariance.data());
+}
+
 void CeresLocalizer::SetCameraParamsConstant() {
   // Set Camera Parameters Constant
   if (problem.HasParameterBlock(camera_intrinsics.data()))
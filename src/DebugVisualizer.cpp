@@ -144,27 +144,48 @@ cv::Mat DebugVisualizer::DrawLandmarks(const cv::Mat& img,
                                        const pose_t& ego_pose) {
   cv::Mat temp = img.clone();
   prepareImg(temp);
-  cv::Point imgPoint;
   for (auto& lm : landmarks) {
-    for (auto& pt : lm.second.points) {
-      // Convert point into camera frame
-      transformWorldToImgCv(pt, camera_intrinsics, ego_pose, imgPoint);
-      circle(temp, imgPoint, POINT_RADIUS_MAP, FZI_RED, POINT_THICKNESS);
-    }
+    drawMapLandmark(temp, lm.second, camera_intrinsics, ego_pose);
+  }
+  return temp;
+}
 
-    transformWorldToImgCv(lm.second.points.front(), camera_intrinsics, ego_pose, imgPoint);
-    imgPoint.x += TEXT_OFFSET;
-    imgPoint.y += TEXT_OFFSET - 28. * FONT_SCALE;
-    putText(temp,
-            getIDstring(lm.second.id),
-            imgPoint,
-            cv::FONT_HERSHEY_DUPLEX,
-            FONT_SCALE,
-            cv::viz::Color::black());
+cv::Mat DebugVisualizer::DrawLandmarks(const cv::Mat& img,
+                                       const LandmarkMap& map,
+                                       const camera_params_t& camera_intrinsics,
+                                       const pose_t& ego_pose) {
+  cv::Mat temp = img.clone();
+  prepareImg(temp);
+  std::vector<landmark_id_t> visible_ids;
+  map.getVisibleLandmarks(ego_pose, camera_intrinsics, img.cols, img.rows, visible_ids);
+  for (auto& id : visible_ids) {
+    drawMapLandmark(temp, map.getWorldLandmarks().at(id), camera_intrinsics, ego_pose);
   }
   return temp;
 }
 
+void DebugVisualizer::drawMapLandmark(cv::Mat& img,
+                                      const Landmark& landmark,
+                                      const camera_params_t& camera_intrinsics,
+                                      const pose_t& ego_pose) {
+  cv::Point imgPoint;
+  for (auto& pt : landmark.points) {
+    // Convert point into camera frame
+    transformWorldToImgCv(pt, camera_intrinsics, ego_pose, imgPoint);
+    circle(img, imgPoint, POINT_RADIUS_MAP, FZI_RED, POINT_THICKNESS);
+  }
+
+  transformWorldToImgCv(landmark.points.front(), camera_intrinsics, ego_pose, imgPoint);
+  imgPoint.x += TEXT_OFFSET;
+  imgPoint.y += TEXT_OFFSET - 28. * FONT_SCALE;
+  putText(img,
+          getIDstring(landmark.id),
+          imgPoint,
+          cv::FONT_HERSHEY_DUPLEX,
+          FONT_SCALE,
+          cv::viz::Color::black());
+}
+
 void DebugVisualizer::transformWorldToImgCv(const Point& p,
                                             const camera_params_t& camera_intrinsics,
                                             const pose_t& ego_pose,
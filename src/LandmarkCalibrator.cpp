@@ -29,6 +29,12 @@ LandmarkCalibrator::LandmarkCalibrator(const std::string& cam_cfgfile,
   readMapConfig(map_cfgfile, landmarks_);
 };
 
+LandmarkCalibrator::LandmarkCalibrator(const std::string& cam_cfgfile,
+                                       const LandmarkMap::ConstPtr& map)
+    : landmarks_(map->getLandmarks()) {
+  readCamConfig(cam_cfgfile, camera_intrinsics_);
+};
+
 void LandmarkCalibrator::AddReprojectionResidualBlocks(
     const std::vector<pose_t>& observed_poses,
     const std::vector<std::vector<ImgLandmark>>& observed_landmarks) {
@@ -58,7 +64,7 @@ void LandmarkCalibrator::AddReprojectionResidualBlocks(
 
       // Add residual block, for every one of the seen points.
       for (size_t k = 0; k < real_lm.points.size(); k++) {
-        const cv::Point* point_under_test;
+        const ImgPoint* point_under_test;
         if (k < 3)
           point_under_test = &observation.corners[k];
         else
@@ -19,18 +19,69 @@
 #include "LandmarkFinder.h"
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <iterator>
 #include <limits>
+#include <mutex>
 
-#include <boost/range/adaptor/reversed.hpp>
+#include "internal/StageTimer.h"
 
 using namespace stargazer;
 
+namespace {
+
+/**
+ * @brief Inner point of the landmark grid in unit landmark coordinates and its value within the ID
+ */
+template <typename Family>
+struct IdPointCandidate {
+  float x;
+  float y;
+  typename Family::id_type value;
+};
+
+template <typename Family>
+constexpr std::array<IdPointCandidate<Family>, Family::kIdPointCount> makeIdPointCandidates() {
+  constexpr int DIM = Family::kGridCount;
+  std::array<IdPointCandidate<Family>, Family::kIdPointCount> candidates{};
+  size_t n = 0;
+  for (int nX = 0; nX < DIM; nX++) {
+    for (int nY = 0; nY < DIM; nY++) {
+      /// skip all corners (4)
+      if (Family::isCorner(nX, nY)) {
+        continue;
+      }
+      candidates[n++] = {float(nX) / (DIM - 1), float(nY) / (DIM - 1), Family::getBit(nX, nY)};
+    }
+  }
+  return candidates;
+}
+
+/**
+ * @brief Table of all inner points (corners excluded), checked by CalculateIdBackward
+ */
+template <typename Family>
+constexpr auto kIdPointCandidates = makeIdPointCandidates<Family>();
+
+}  // namespace
+
 ///--------------------------------------------------------------------------------------///
 /// Default constructor
 ///--------------------------------------------------------------------------------------///
-LandmarkFinder::LandmarkFinder(std::string cfgfile) {
+LandmarkFinder::LandmarkFinder(std::string cfgfile)
+    : LandmarkFinder(std::make_shared<const LandmarkMap>(cfgfile)) {}
+
+LandmarkFinder::LandmarkFinder(LandmarkMap::ConstPtr map)
+    : LandmarkFinder(std::make_shared<LandmarkMapHandle>(std::move(map))) {}
+
+LandmarkFinder::LandmarkFinder(LandmarkMapHandle::Ptr map_handle)
+    : map_handle_(std::move(map_handle)) {
+  map_handle_->Update(workspace_.map, workspace_.mapGeneration);
 
   /// set parameters
+  /// the landmark layout and the largest landmark are taken from the map
 
   // parameters for point detection
   blobParams.filterByArea = false;
@@ -55,7 +106,7 @@ LandmarkFinder::LandmarkFinder(std::string cfgfile) {
   // parameters for clustering
   maxRadiusForCluster = 40;
   minPointsPerLandmark = 5;
-  maxPointsPerLandmark = 9;
+  extraPointsPerLandmark = 3;
 
   // parameters for corner hypotheses
   cornerHypothesesCutoff = 1.0;
@@ -67,14 +118,6 @@ LandmarkFinder::LandmarkFinder(std::string cfgfile) {
 
   // parameters for id calc
   idPointThresholdBackwards = 200.0;
-
-  /// Read in Landmark IDs
-  landmark_map_t landmarks;
-  readMapConfig(cfgfile, landmarks);
-  for (auto& el : landmarks) {
-    valid_ids_.push_back(el.first);
-  }
-  std::sort(valid_ids_.begin(), valid_ids_.end());
 }
 
 ///--------------------------------------------------------------------------------------///
@@ -88,108 +131,235 @@ LandmarkFinder::~LandmarkFinder() {}
 /// Handles the complete processing
 ///--------------------------------------------------------------------------------------///
 int LandmarkFinder::DetectLandmarks(const cv::Mat& img,
-                                    std::vector<ImgLandmark>& detected_landmarks) {
-  points_.clear();
-  clusteredPoints_.clear();
+                                    std::vector<ImgLandmark>& detected_landmarks,
+                                    Workspace& workspace) const {
+  TraceScope trace("DetectLandmarks");
+
+  /// pick up a newly published map, the snapshot stays valid for the whole frame
+  map_handle_->Update(workspace.map, workspace.mapGeneration);
+
+  /// all scratch data of the previous frame is gone, it is allocated from the arena again
+  workspace.arena.Reset();
+  std::pmr::memory_resource* arena = workspace.arena.getResource();
+  ScratchPoints points(arena);
+  ScratchClusters clusteredPoints(arena);
 
   detected_landmarks.clear();
 
+  DetectionStats* const stats = workspace.stats;
+  if (stats) {
+    *stats = DetectionStats();
+  }
+
   /// check if input is valid
   // Explanation for CV_ Codes:
   // CV_[The number of bits per item][Signed or Unsigned][Type Prefix]C[The channel number]
-  img.assignTo(grayImage_, CV_8UC1);  // 8bit unsigned with 3 channels
-  if (!grayImage_.data) {             /// otherwise: return with error
+  {
+    StageTimer timer(stats, &DetectionStats::grayscaleTime, "Grayscale");
+    img.assignTo(workspace.grayImage, CV_8UC1);  // 8bit unsigned with 3 channels
+  }
+  if (!workspace.grayImage.data) {             /// otherwise: return with error
     std::cerr << "Input data is invalid" << std::endl;
     return -1;
   }
+  DebugSink* const sink = workspace.debugSink;
+  if (sink) {
+    workspace.grayImage.copyTo(sink->grayImage);
+  }
 
   /// This method finds bright points in image returns vector of center points of pixel groups
-  points_ = FindBlobs(grayImage_);
+  {
+    StageTimer timer(stats, &DetectionStats::blobTime, "FindBlobs");
+    FindBlobs(workspace, points);
+  }
+  if (stats) {
+    stats->blobCount = static_cast<uint32_t>(points.size());
+  }
+  if (sink) {
+    sink->points.assign(points.begin(), points.end());
+  }
 
   /// cluster points to groups which could be landmarks
   /// returns a vector of clusters which themselves are vectors of points
-  FindClusters(points_, clusteredPoints_, maxRadiusForCluster, minPointsPerLandmark, maxPointsPerLandmark);
+  /// clusters much larger than every landmark of the map are dropped
+  /// larger clusters can not be stored in an ImgLandmark
+  const unsigned int maxPoints = static_cast<unsigned int>(
+      std::min<size_t>(workspace.map->getMaxPointCount() + extraPointsPerLandmark,
+                       3 + ImgLandmark::kMaxIdPoints));
+  {
+    StageTimer timer(stats, &DetectionStats::clusterTime, "FindClusters");
+    FindClusters(points, clusteredPoints, maxRadiusForCluster, minPointsPerLandmark, maxPoints);
+  }
+  if (stats) {
+    stats->clusterCount = static_cast<uint32_t>(clusteredPoints.size());
+  }
+  if (sink) {
+    sink->clusteredPoints.clear();
+    for (size_t c = 0; c < clusteredPoints.size(); c++) {
+      sink->clusteredPoints.emplace_back(clusteredPoints[c].begin(), clusteredPoints[c].end());
+    }
+  }
 
   /// on the clustered points, extract corners
   /// output is of type landmark, because now you can almost be certain that
   /// what you have is a landmark
-  detected_landmarks = FindLandmarks(clusteredPoints_);
+  FindLandmarks(clusteredPoints, workspace, detected_landmarks);
 
   return 0;
 }
 
+///--------------------------------------------------------------------------------------///
+/// DetectLandmarksBatch processes many frames on several threads
+///
+///--------------------------------------------------------------------------------------///
+int LandmarkFinder::DetectLandmarksBatch(const std::vector<cv::Mat>& images,
+                                         std::vector<std::vector<ImgLandmark>>& detected_landmarks,
+                                         size_t thread_count) const {
+  detected_landmarks.resize(images.size());
+  thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(images.size(), 1));
+
+  /// every thread takes the next unprocessed image, results go to the slot of their image
+  std::atomic<size_t> next_image{0};
+  std::atomic<int> result{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto worker = [&]() {
+    try {
+      /// allocates as well, so its failure is reported like a failed detection
+      Workspace workspace;
+      for (size_t i = next_image++; i < images.size(); i = next_image++) {
+        if (DetectLandmarks(images[i], detected_landmarks[i], workspace) != 0) {
+          result = -1;
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      next_image = images.size();  /// stop all threads
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  try {
+    for (size_t t = 1; t < thread_count; t++) {
+      threads.emplace_back(worker);
+    }
+    worker();  /// the calling thread works as well
+  } catch (...) {
+    /// e.g. no more threads available: the started ones must be joined before unwinding
+    next_image = images.size();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    throw;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return result;
+}
+
 ///--------------------------------------------------------------------------------------///
 /// FindClusters groups points from input vector into groups
 ///
 ///--------------------------------------------------------------------------------------///
-void LandmarkFinder::FindClusters(const std::vector<cv::Point>& points_in,
-                                  std::vector<Cluster>& clusters,
+void LandmarkFinder::FindClusters(const ScratchPoints& points_in,
+                                  ScratchClusters& clusters,
                                   const double radiusThreshold,
                                   const unsigned int minPointsThreshold,
                                   const unsigned int maxPointsThreshold) const {
-
-  for (auto& thisPoint : points_in)  /// go thru all points
+  constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+  std::pmr::memory_resource* arena = clusters.points.get_allocator().resource();
+  const uint32_t count = static_cast<uint32_t>(points_in.size());
+
+  /// clusters are linked lists of point indices while grouping, no points are moved
+  std::pmr::vector<uint32_t> next(count, kNone, arena); /// next point of the same cluster
+  std::pmr::vector<uint32_t> first(arena);              /// first point of every cluster
+  std::pmr::vector<uint32_t> last(arena);               /// last point of every cluster
+  std::pmr::vector<uint32_t> size(arena);               /// number of points of every cluster
+  first.reserve(count);
+  last.reserve(count);
+  size.reserve(count);
+
+  for (uint32_t i = 0; i < count; i++)  /// go thru all points
   {
-    bool clusterFound = 0;  /// set flag that not used yet
+    const cv::Point& thisPoint = points_in[i];
+    uint32_t cluster = kNone;  /// set flag that not used yet
 
     /// the last created cluster is most liley the one we are looking for
-    for (auto& cluster : boost::adaptors::reverse(clusters)) {  /// go thru all clusters
-      for (auto& clusterPoint : cluster) {  /// go thru all points in this cluster
+    for (uint32_t c = static_cast<uint32_t>(first.size()); c-- > 0 && cluster == kNone;) {
+      for (uint32_t j = first[c]; j != kNone; j = next[j]) {  /// go thru all points in this cluster
         /// if distance is smaller than threshold, add point to cluster
-        if (cv::norm(clusterPoint - thisPoint) <= radiusThreshold) {
-          cluster.push_back(thisPoint);
-          clusterFound = true;
+        if (cv::norm(points_in[j] - thisPoint) <= radiusThreshold) {
+          cluster = c;
           break;  /// because point has been added to cluster, no further search is neccessary
         }
       }
-
-      if (clusterFound)  /// because point has been added to cluster, no further search is neccessary
-        break;
     }
 
-    if (!clusterFound)  /// not assigned to any cluster
+    if (cluster == kNone)  /// not assigned to any cluster
     {
-      Cluster newCluster;               /// create new cluster
-      newCluster.push_back(thisPoint);  /// put this point in this new cluster
-      clusters.push_back(newCluster);   /// add this cluster to the list
+      first.push_back(i);  /// create new cluster with this point
+      last.push_back(i);
+      size.push_back(1);
+    } else {
+      next[last[cluster]] = i;
+      last[cluster] = i;
+      size[cluster]++;
     }
   }
 
-  /// second rule: check for minimum and maximum of points per cluster
-  clusters.erase(std::remove_if(clusters.begin(),
-                                clusters.end(),
-                                [&](Cluster& cluster) {
-                                  return (minPointsThreshold > cluster.size() ||
-                                          maxPointsThreshold < cluster.size());
-                                }),
-                 clusters.end());
+  /// second rule: check for minimum and maximum of points per cluster.
+  /// The remaining clusters are copied into consecutive rows.
+  clusters.offsets.assign(1, 0);
+  clusters.points.clear();
+  clusters.indices.clear();
+  clusters.points.reserve(count);
+  clusters.indices.reserve(count);
+  for (size_t c = 0; c < first.size(); c++) {
+    if (minPointsThreshold > size[c] || maxPointsThreshold < size[c]) {
+      continue;
+    }
+    for (uint32_t j = first[c]; j != kNone; j = next[j]) {
+      clusters.points.push_back(points_in[j]);
+      clusters.indices.push_back(j);
+    }
+    clusters.offsets.push_back(static_cast<uint32_t>(clusters.points.size()));
+  }
 }
 
-std::vector<cv::Point> LandmarkFinder::FindBlobs(cv::Mat& img_in) const {
+void LandmarkFinder::FindBlobs(Workspace& workspace, ScratchPoints& points) const {
   // BlobDetector with latest parameters
-  std::vector<cv::KeyPoint> keypoints;
   cv::Ptr<cv::SimpleBlobDetector> detector = cv::SimpleBlobDetector::create(blobParams);
-  detector->detect(img_in, keypoints);
+  detector->detect(workspace.grayImage, workspace.keypoints);
 
-  // two step conversion
   // TODO use float values instead?
-  std::vector<cv::Point2f> points2f;
-  cv::KeyPoint::convert(keypoints, points2f);
-  std::vector<cv::Point> points;
-  cv::Mat(points2f).convertTo(points, cv::Mat(points).type());
-
-  return points;
+  points.reserve(workspace.keypoints.size());
+  for (const cv::KeyPoint& keypoint : workspace.keypoints) {
+    points.emplace_back(cvRound(keypoint.pt.x), cvRound(keypoint.pt.y));
+  }
 }
 
 ///--------------------------------------------------------------------------------------///
 /// FindCorners identifies the three corner points and sorts them into output vector
 /// -> find three points which maximize a certain score for corner points
 ///--------------------------------------------------------------------------------------///
-std::vector<ImgLandmark> LandmarkFinder::FindCorners(const std::vector<cv::Point>& point_list) {
+uint64_t LandmarkFinder::FindCorners(const PointRange& point_list,
+                                     std::pmr::memory_resource* arena,
+                                     std::vector<ImgLandmark>& hypotheses) const {
 
   typedef std::pair<double, ImgLandmark> LmHypothesis;
-  std::vector<LmHypothesis> scored_hypotheses;
+  std::pmr::vector<LmHypothesis> scored_hypotheses(arena);
+  ScratchPoints2f local_points(arena);
+  local_points.reserve(point_list.size());
   double best_score = std::numeric_limits<double>::lowest();  // Score for best combination of points
+  uint64_t triples = 0;
 
   /*  Numbering of corners and coordinate frame FOR THIS FUNCTION ONLY
    *       ---> y
@@ -212,6 +382,7 @@ std::vector<ImgLandmark> LandmarkFinder::FindCorners(const std::vector<cv::Point
           // Skip double assignments
           continue;
         }
+        triples++;
 
         // ensure rhs
         if (0. > (pH1 - pS).cross(pH2 - pS)) {
@@ -236,9 +407,7 @@ std::vector<ImgLandmark> LandmarkFinder::FindCorners(const std::vector<cv::Point
         }
 
         // check if each point is on correct side of assumed secant
-        std::vector<cv::Point2f> local_points;
-        local_points.reserve(point_list.size());
-        cv::Mat(point_list).convertTo(local_points, cv::Mat(local_points).type());
+        local_points.assign(point_list.begin(), point_list.end());
         TransformToLocalPoints(pA, pS, pB, local_points);
         bool is_point_invalid = false;
         for (cv::Point2f pL : local_points) {
@@ -274,7 +443,7 @@ std::vector<ImgLandmark> LandmarkFinder::FindCorners(const std::vector<cv::Point
           }
           lm.idPoints.push_back(point_list[n]);
         }
-        scored_hypotheses.push_back(LmHypothesis(score, lm));
+        scored_hypotheses.emplace_back(score, std::move(lm));
 
         best_score = std::max(score, best_score);
       }
@@ -282,56 +451,79 @@ std::vector<ImgLandmark> LandmarkFinder::FindCorners(const std::vector<cv::Point
   }
   // Sort out bad hypotheses (relative to total best)
   auto bad_end = std::remove_if(
-      scored_hypotheses.begin(), scored_hypotheses.end(), [this, best_score](LmHypothesis lmh) {
+      scored_hypotheses.begin(), scored_hypotheses.end(), [this, best_score](const LmHypothesis& lmh) {
         return lmh.first < cornerHypothesesCutoff * best_score;
       });
 
   // Sort by score
-  std::sort(scored_hypotheses.begin(), bad_end, [](LmHypothesis a, LmHypothesis b) {
+  std::sort(scored_hypotheses.begin(), bad_end, [](const LmHypothesis& a, const LmHypothesis& b) {
     return a.first > b.first;
   });
 
   // Return the best hypotheses (considering a maximum count)
-  std::vector<ImgLandmark> hypotheses;
   for (auto it = scored_hypotheses.begin();
        it != bad_end && it != scored_hypotheses.begin() + maxCornerHypotheses;
        it++) {
     hypotheses.push_back(std::move(it->second));
   }
-  return hypotheses;
+  return triples;
 }
 
 ///--------------------------------------------------------------------------------------///
 /// FindLandmarks identifies landmark inside a point cluster
 ///
 ///--------------------------------------------------------------------------------------///
-std::vector<ImgLandmark> LandmarkFinder::FindLandmarks(const std::vector<Cluster>& clusteredPoints) {
-  landmarkHypotheses_.clear();
-  for (auto& cluster : clusteredPoints) {  /// go thru all clusters
-
-    /// FindCorners will move the three corner points into the corners vector
-    std::vector<ImgLandmark> result = FindCorners(cluster);
-    landmarkHypotheses_.insert(landmarkHypotheses_.end(), result.begin(), result.end());
+void LandmarkFinder::FindLandmarks(const ScratchClusters& clusteredPoints,
+                                   Workspace& workspace,
+                                   std::vector<ImgLandmark>& OutputLandmarks) const {
+  DetectionStats* const stats = workspace.stats;
+  StageTimer corner_timer(stats, &DetectionStats::cornerTime, "FindCorners");
+  uint64_t triples = 0;
+  for (size_t c = 0; c < clusteredPoints.size(); c++) {  /// go thru all clusters
+
+    /// FindCorners will append the hypotheses of this cluster
+    triples += FindCorners(clusteredPoints[c], workspace.arena.getResource(), OutputLandmarks);
+  }
+  corner_timer.Stop();
+  if (stats) {
+    stats->triplesEvaluated = triples;
+    stats->hypothesisCount = static_cast<uint32_t>(OutputLandmarks.size());
+  }
+  /// hypotheses are only copied for debugging, GetIDs modifies them in place
+  if (workspace.debugSink) {
+    workspace.debugSink->landmarkHypotheses = OutputLandmarks;
   }
-  std::vector<ImgLandmark> OutputLandmarks(landmarkHypotheses_);
-  GetIDs(OutputLandmarks);
 
-  /// done and return landmarks
-  return OutputLandmarks;
+  /// the ID decoding is instantiated for every landmark family, the map defines the one in use
+  StageTimer id_timer(stats, &DetectionStats::idTime, "GetIDs");
+  switch (workspace.map->getFamily()) {
+    case LANDMARK_FAMILY::GRID_5x5:
+      GetIDs<LandmarkFamily5x5>(OutputLandmarks, workspace);
+      break;
+    case LANDMARK_FAMILY::GRID_6x6:
+      GetIDs<LandmarkFamily6x6>(OutputLandmarks, workspace);
+      break;
+    default:
+      GetIDs<LandmarkFamily4x4>(OutputLandmarks, workspace);
+      break;
+  }
 }
 
 ///--------------------------------------------------------------------------------------///
 /// CalculateIdForward sorts the given idPoints and calculates the id
 ///
 ///--------------------------------------------------------------------------------------///
-uint16_t LandmarkFinder::CalculateIdForward(const ImgLandmark& landmark) const {
-  std::vector<cv::Point2f> local_points;
-  cv::Mat(landmark.idPoints).convertTo(local_points, cv::Mat(local_points).type());
+template <typename Family>
+landmark_id_t LandmarkFinder::CalculateIdForward(const ImgLandmark& landmark,
+                                                 ScratchPoints2f& local_points) const {
+  constexpr int DIM = Family::kGridCount;
+
+  local_points.assign(landmark.idPoints.begin(), landmark.idPoints.end());
   TransformToLocalPoints(
       landmark.corners.at(0), landmark.corners.at(1), landmark.corners.at(2), local_points);
 
   /// the total ID
-  uint16_t ID = 0;
+  typename Family::id_type ID = 0;
 
   /// go thru all ID points in this landmark structure
   for (const auto& p : local_points) {
@@ -345,7 +537,7 @@ uint16_t LandmarkFinder::CalculateIdForward(const ImgLandmark& landmark) const {
     /// x steps are binary shifts within 4 bit blocks
     /// y steps are binary shifts of 4 bit blocks
     /// see http://hagisonic.com/ for more information on this
-    ID += static_cast<uint16_t>(1 << (nX + DIM * nY));
+    ID += Family::getBit(nX, nY);
   }
   return ID;
 }
@@ -354,49 +546,35 @@ uint16_t LandmarkFinder::CalculateIdForward(const ImgLandmark& landmark) const {
 /// CalculateIdBackward searches in the filtered image for id points, given the corners.
 ///
 ///--------------------------------------------------------------------------------------///
-bool LandmarkFinder::CalculateIdBackward(ImgLandmark& landmark) const {
+template <typename Family>
+bool LandmarkFinder::CalculateIdBackward(ImgLandmark& landmark, const cv::Mat& grayImage) const {
   /// now we delete the previously detected points and go the other way around
-  uint16_t ID = 0;
+  typename Family::id_type ID = 0;
   landmark.idPoints.clear();
 
-  const cv::Point& x0y0 = landmark.corners.at(0);
-  const cv::Point& x1y0 = landmark.corners.at(1);
-  const cv::Point& x1y1 = landmark.corners.at(2);
-
-  std::vector<cv::Point2f> id_points;
-  std::vector<uint16_t> id_point_values;
-  id_points.reserve(DIM * DIM - 3);
-  id_point_values.reserve(DIM * DIM - 3);
-
-  // setup id points in local coordinates and their encoded value
-  for (int nX = 0; nX < DIM; nX++) {
-    for (int nY = 0; nY < DIM; nY++) {
-      /// skip all corners (4)
-      if ((nX == 0 || nX == DIM - 1) && (nY == 0 || nY == DIM - 1)) {
-        continue;
-      }
-      id_points.push_back(cv::Point2f(float(nX) / (DIM - 1), float(nY) / (DIM - 1)));
-      id_point_values.push_back(static_cast<uint16_t>(1 << (nX + DIM * nY)));
-    }
-  }
+  const cv::Point2f x0y0 = landmark.corners.at(0);
+  const cv::Point2f x1y0 = landmark.corners.at(1);
+  const cv::Point2f x1y1 = landmark.corners.at(2);
 
   /// same as before: finde affine transformation, but this time from landmark
   /// coordinates to image coordinates
-  TransformToGlobalPoints(x0y0, x1y0, x1y1, id_points);
+  const cv::Point2f vX = x1y0 - x0y0;
+  const cv::Point2f vY = x1y1 - x1y0;
 
   /// check image for bright spots
-  for (size_t n = 0; n < id_points.size(); n++) {
-    cv::Point img_point(id_points[n].x, id_points[n].y);
-    if (0 > img_point.x || 0 > img_point.y || grayImage_.cols <= img_point.x ||
-        grayImage_.rows <= img_point.y) {
+  for (const IdPointCandidate<Family>& candidate : kIdPointCandidates<Family>) {
+    const cv::Point2f id_point = x0y0 + candidate.x * vX + candidate.y * vY;
+    cv::Point img_point(id_point.x, id_point.y);
+    if (0 > img_point.x || 0 > img_point.y || grayImage.cols <= img_point.x ||
+        grayImage.rows <= img_point.y) {
       // corner hypothesis suggest id points outside of visible area. No safe detection possible.
       return false;
     }
     /// todo: this might be extended to some area
     if (idPointThresholdBackwards <
-        grayImage_.at<uint8_t>(img_point.y, img_point.x)) {
+        grayImage.at<uint8_t>(img_point.y, img_point.x)) {
       landmark.idPoints.push_back(img_point);
-      ID += id_point_values[n];
+      ID += candidate.value;
     }
   }
   landmark.nID = ID;
@@ -407,20 +585,43 @@ bool LandmarkFinder::CalculateIdBackward(ImgLandmark& landmark) const {
 /// GetIDs is to identify the ID of a landmark according to the point pattern
 /// see http://hagisonic.com/ for information on pattern
 ///--------------------------------------------------------------------------------------///
-void LandmarkFinder::GetIDs(std::vector<ImgLandmark>& landmarks) {
+template <typename Family>
+void LandmarkFinder::GetIDs(std::vector<ImgLandmark>& landmarks, Workspace& workspace) const {
   // Try to get IDs for landmark hypotheses.
   // Landmarks which couldn't be recognized in a forward manner are given a second chance.
   // Landmarks can be recognized several times per method, since no ranking can be defined.
   // The valid ids for the second method are the remaining ids.
 
-  std::vector<uint16_t> unseenIDs = valid_ids_;
-  std::vector<uint16_t> seenIDs;
+  std::pmr::memory_resource* arena = workspace.arena.getResource();
+
+  // Candidates are all IDs of the map, or the ones visible from the hinted position. Outside of
+  // the table's area the hint is of no use, e.g. after the camera left the compiled floor space.
+  // A table compiled for another map, e.g. before an update got published, is ignored.
+  std::pmr::vector<landmark_id_t> unseenIDs(arena);
+  if (visibility_table_ && workspace.hasPositionHint &&
+      visibility_table_->getMapFingerprint() == workspace.map->getFingerprint() &&
+      visibility_table_->contains(workspace.positionHint[(int)POINT::X],
+                                  workspace.positionHint[(int)POINT::Y])) {
+    for (landmark_id_t id : visibility_table_->getVisibleIds(workspace.positionHint[(int)POINT::X],
+                                                        workspace.positionHint[(int)POINT::Y])) {
+      if (workspace.map->contains(id)) {
+        unseenIDs.push_back(id);
+      }
+    }
+  } else {
+    unseenIDs.assign(workspace.map->getIds().begin(), workspace.map->getIds().end());
+  }
+  std::pmr::vector<landmark_id_t> seenIDs(arena);
+  seenIDs.reserve(landmarks.size());
+  ScratchPoints2f local_points(arena);
 
   // Move landmarks, for which no valid id could be calculated, back
   auto unknownLandmarksBegin = std::partition(
-      landmarks.begin(), landmarks.end(), [this, &unseenIDs, &seenIDs](ImgLandmark& lm) {
-        uint16_t id = CalculateIdForward(lm);
-        if (std::find(unseenIDs.begin(), unseenIDs.end(), id) != unseenIDs.end()) {
+      landmarks.begin(),
+      landmarks.end(),
+      [this, &unseenIDs, &seenIDs, &local_points](ImgLandmark& lm) {
+        landmark_id_t id = CalculateIdForward<Family>(lm, local_points);
+        if (std::binary_search(unseenIDs.begin(), unseenIDs.end(), id)) {
           // Valid ID
           lm.nID = id;
           seenIDs.push_back(id);
@@ -433,19 +634,20 @@ void LandmarkFinder::GetIDs(std::vector<ImgLandmark>& landmarks) {
   std::sort(seenIDs.begin(), seenIDs.end());
   auto ib = seenIDs.begin();
   auto iter = std::remove_if(
-      std::begin(unseenIDs), std::end(unseenIDs), [&seenIDs, &ib](uint16_t id) {
+      std::begin(unseenIDs), std::end(unseenIDs), [&seenIDs, &ib](landmark_id_t id) {
         while (ib != seenIDs.end() && *ib < id) ++ib;
         return (ib != seenIDs.end() && *ib == id);
       });
-  if (iter != unseenIDs.end()) {
-    unseenIDs.erase(iter);
-  }
+  unseenIDs.erase(iter, unseenIDs.end());
+  const size_t forward_count = seenIDs.size();
 
   // Move landmarks, for which no valid id could be calculated, back
   unknownLandmarksBegin = std::remove_if(
-      unknownLandmarksBegin, landmarks.end(), [this, &unseenIDs, &seenIDs](ImgLandmark& lm) {
-        if (CalculateIdBackward(lm)) {
-          if (std::find(unseenIDs.begin(), unseenIDs.end(), lm.nID) != unseenIDs.end()) {
+      unknownLandmarksBegin,
+      landmarks.end(),
+      [this, &workspace, &unseenIDs, &seenIDs](ImgLandmark& lm) {
+        if (CalculateIdBackward<Family>(lm, workspace.grayImage)) {
+          if (std::binary_search(unseenIDs.begin(), unseenIDs.end(), lm.nID)) {
             seenIDs.push_back(lm.nID);
             return false;
           }
@@ -455,29 +657,30 @@ void LandmarkFinder::GetIDs(std::vector<ImgLandmark>& landmarks) {
 
   // Erase landmark hypotheses for which both methods did not return a valid id
   landmarks.erase(unknownLandmarksBegin, landmarks.end());
+
+  if (workspace.stats) {
+    workspace.stats->forwardIdCount = static_cast<uint32_t>(forward_count);
+    workspace.stats->backwardIdCount = static_cast<uint32_t>(seenIDs.size() - forward_count);
+  }
 }
 
 void LandmarkFinder::TransformToLocalPoints(const cv::Point2f& x0y0,
                                             const cv::Point2f& x1y0,
                                             const cv::Point2f& x1y1,
-                                            std::vector<cv::Point2f>& p) const {
-  std::transform(
-      p.begin(), p.end(), p.begin(), [x0y0](cv::Point2f p) { return p - x0y0; });
-
+                                            ScratchPoints2f& p) const {
   const cv::Point2f vX = x1y0 - x0y0;
   const cv::Point2f vY = x1y1 - x1y0;
 
-  const cv::Matx22f transform(vX.x, vY.x, vX.y, vY.y);
-  cv::transform(p, p, transform.inv());
-}
-
-void LandmarkFinder::TransformToGlobalPoints(const cv::Point2f& x0y0,
-                                             const cv::Point2f& x1y0,
-                                             const cv::Point2f& x1y1,
-                                             std::vector<cv::Point2f>& p) const {
-  const cv::Point2f vX = x1y0 - x0y0;
-  const cv::Point2f vY = x1y1 - x1y0;
-  std::transform(p.begin(), p.end(), p.begin(), [&x0y0, &vX, &vY](cv::Point2f p) {
-    return x0y0 + p.x * vX + p.y * vY;
-  });
+  /// inverse of the matrix (vX vY), applied in place without temporary matrices
+  const float det = vX.x * vY.y - vY.x * vX.y;
+  if (det == 0.f) {
+    // Collinear corners. Like cv::Matx::inv, a singular matrix gets inverted to zero.
+    std::fill(p.begin(), p.end(), cv::Point2f(0.f, 0.f));
+    return;
+  }
+  const float a = vY.y / det, b = -vY.x / det, c = -vX.y / det, d = vX.x / det;
+  for (cv::Point2f& pt : p) {
+    const cv::Point2f q = pt - x0y0;
+    pt = cv::Point2f(a * q.x + b * q.y, c * q.x + d * q.y);
+  }
 }
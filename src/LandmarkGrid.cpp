@@ -0,0 +1,212 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "LandmarkGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+using namespace stargazer;
+
+namespace {
+
+struct Box {
+  double x_min = std::numeric_limits<double>::max();
+  double y_min = std::numeric_limits<double>::max();
+  double x_max = std::numeric_limits<double>::lowest();
+  double y_max = std::numeric_limits<double>::lowest();
+};
+
+Box getBox(const Landmark& lm) {
+  Box box;
+  for (auto& pt : lm.points) {
+    box.x_min = std::min(box.x_min, pt[(int)POINT::X]);
+    box.y_min = std::min(box.y_min, pt[(int)POINT::Y]);
+    box.x_max = std::max(box.x_max, pt[(int)POINT::X]);
+    box.y_max = std::max(box.y_max, pt[(int)POINT::Y]);
+  }
+  return box;
+}
+
+}  // namespace
+
+LandmarkGrid::LandmarkGrid(const landmark_map_t& world_landmarks, double cell_size)
+    : cell_size_(cell_size) {
+  if (world_landmarks.empty()) {
+    cell_offsets_.assign(1, 0);
+    return;
+  }
+
+  /// Determine extent of the map
+  Box extent;
+  std::vector<Box> boxes;
+  boxes.reserve(world_landmarks.size());
+  for (auto& el : world_landmarks) {
+    boxes.push_back(getBox(el.second));
+    extent.x_min = std::min(extent.x_min, boxes.back().x_min);
+    extent.y_min = std::min(extent.y_min, boxes.back().y_min);
+    extent.x_max = std::max(extent.x_max, boxes.back().x_max);
+    extent.y_max = std::max(extent.y_max, boxes.back().y_max);
+  }
+  x_origin_ = extent.x_min;
+  y_origin_ = extent.y_min;
+  cols_ = static_cast<int>((extent.x_max - extent.x_min) / cell_size_) + 1;
+  rows_ = static_cast<int>((extent.y_max - extent.y_min) / cell_size_) + 1;
+
+  /// Count entries per cell, then fill them (compressed rows)
+  cell_offsets_.assign(cols_ * rows_ + 1, 0);
+  for (auto& box : boxes) {
+    for (int row = getRow(box.y_min); row <= getRow(box.y_max); row++) {
+      for (int col = getCol(box.x_min); col <= getCol(box.x_max); col++) {
+        cell_offsets_[row * cols_ + col + 1]++;
+      }
+    }
+  }
+  for (size_t i = 1; i < cell_offsets_.size(); i++) {
+    cell_offsets_[i] += cell_offsets_[i - 1];
+  }
+  cell_ids_.resize(cell_offsets_.back());
+  std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+  auto box = boxes.begin();
+  // landmark_map_t is ordered, so every cell holds ascending ids
+  for (auto& el : world_landmarks) {
+    for (int row = getRow(box->y_min); row <= getRow(box->y_max); row++) {
+      for (int col = getCol(box->x_min); col <= getCol(box->x_max); col++) {
+        cell_ids_[fill[row * cols_ + col]++] = el.first;
+      }
+    }
+    ++box;
+  }
+}
+
+void LandmarkGrid::QueryBox(double x_min,
+                            double y_min,
+                            double x_max,
+                            double y_max,
+                            std::vector<landmark_id_t>& ids) const {
+  ids.clear();
+  if (cols_ == 0 || x_max < x_origin_ || y_max < y_origin_ ||
+      x_min > x_origin_ + cols_ * cell_size_ || y_min > y_origin_ + rows_ * cell_size_) {
+    return;
+  }
+  for (int row = getRow(y_min); row <= getRow(y_max); row++) {
+    for (int col = getCol(x_min); col <= getCol(x_max); col++) {
+      const int cell = row * cols_ + col;
+      ids.insert(ids.end(),
+                 cell_ids_.begin() + cell_offsets_[cell],
+                 cell_ids_.begin() + cell_offsets_[cell + 1]);
+    }
+  }
+  // Landmarks covering several cells are found multiple times
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+bool LandmarkGrid::Update(const landmark_map_t& erased, const landmark_map_t& inserted) {
+  if (cols_ == 0) {
+    return inserted.empty();
+  }
+
+  /// Inserted landmarks have to fit into the current extent
+  std::vector<Box> boxes;
+  boxes.reserve(inserted.size());
+  for (auto& el : inserted) {
+    boxes.push_back(getBox(el.second));
+    if (boxes.back().x_min < x_origin_ || boxes.back().y_min < y_origin_ ||
+        boxes.back().x_max >= x_origin_ + cols_ * cell_size_ ||
+        boxes.back().y_max >= y_origin_ + rows_ * cell_size_) {
+      return false;
+    }
+  }
+
+  /// Cells covered by erased or inserted landmarks. All other cells keep their entries.
+  std::vector<uint32_t> affected;
+  std::vector<landmark_id_t> erased_ids;
+  erased_ids.reserve(erased.size());
+  for (auto& el : erased) {
+    erased_ids.push_back(el.first);
+    const Box box = getBox(el.second);
+    for (int row = getRow(box.y_min); row <= getRow(box.y_max); row++) {
+      for (int col = getCol(box.x_min); col <= getCol(box.x_max); col++) {
+        affected.push_back(row * cols_ + col);
+      }
+    }
+  }
+  std::vector<std::pair<uint32_t, landmark_id_t>> inserted_entries;  // (cell, id)
+  auto box = boxes.begin();
+  for (auto& el : inserted) {
+    for (int row = getRow(box->y_min); row <= getRow(box->y_max); row++) {
+      for (int col = getCol(box->x_min); col <= getCol(box->x_max); col++) {
+        affected.push_back(row * cols_ + col);
+        inserted_entries.emplace_back(row * cols_ + col, el.first);
+      }
+    }
+    ++box;
+  }
+  std::sort(affected.begin(), affected.end());
+  affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+  std::sort(inserted_entries.begin(), inserted_entries.end());
+
+  /// Unaffected cells are copied as a block, affected ones are merged with the inserted ids
+  const size_t cell_count = cell_offsets_.size() - 1;
+  std::vector<uint32_t> cell_offsets(cell_offsets_.size(), 0);
+  std::vector<landmark_id_t> cell_ids;
+  cell_ids.reserve(cell_ids_.size() + inserted_entries.size());
+  size_t cell = 0;
+  auto copy_cells = [&](size_t end) {
+    const size_t shift = cell_ids.size() - cell_offsets_[cell];
+    cell_ids.insert(cell_ids.end(),
+                    cell_ids_.begin() + cell_offsets_[cell],
+                    cell_ids_.begin() + cell_offsets_[end]);
+    for (; cell < end; cell++) {
+      cell_offsets[cell + 1] = static_cast<uint32_t>(cell_offsets_[cell + 1] + shift);
+    }
+  };
+  auto entry = inserted_entries.begin();
+  for (const uint32_t next : affected) {
+    copy_cells(next);
+    const size_t begin = cell_ids.size();
+    std::set_difference(cell_ids_.begin() + cell_offsets_[cell],
+                        cell_ids_.begin() + cell_offsets_[cell + 1],
+                        erased_ids.begin(),
+                        erased_ids.end(),
+                        std::back_inserter(cell_ids));
+    const size_t middle = cell_ids.size();
+    for (; entry != inserted_entries.end() && entry->first == next; ++entry) {
+      cell_ids.push_back(entry->second);
+    }
+    std::inplace_merge(cell_ids.begin() + begin, cell_ids.begin() + middle, cell_ids.end());
+    cell_offsets[++cell] = static_cast<uint32_t>(cell_ids.size());
+  }
+  copy_cells(cell_count);
+  cell_offsets_.swap(cell_offsets);
+  cell_ids_.swap(cell_ids);
+  return true;
+}
+
+int LandmarkGrid::getCol(double x) const {
+  // Clamp before casting, queries may reach far beyond the map
+  return static_cast<int>(std::clamp(std::floor((x - x_origin_) / cell_size_), 0., cols_ - 1.));
+}
+
+int LandmarkGrid::getRow(double y) const {
+  return static_cast<int>(std::clamp(std::floor((y - y_origin_) / cell_size_), 0., rows_ - 1.));
+}
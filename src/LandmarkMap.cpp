@@ -0,0 +1,318 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "LandmarkMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "BinaryMap.h"
+#include "CoordinateTransformations.h"
+#include "StargazerConfig.h"
+
+using namespace stargazer;
+
+namespace {
+
+bool isBinaryMap(const std::string& mapfile) {
+  char magic[sizeof(kBinaryMapMagic)] = {};
+  std::ifstream fin(mapfile, std::ios::binary);
+  fin.read(magic, sizeof(magic));
+  return fin && std::memcmp(magic, kBinaryMapMagic, sizeof(magic)) == 0;
+}
+
+void transformLandmarkToWorld(Landmark& lm) {
+  for (auto& pt : lm.points) {
+    double x, y, z;
+    transformLandMarkToWorld(pt[(int)POINT::X], pt[(int)POINT::Y], lm.pose.data(), &x, &y, &z);
+    pt = {x, y, z};
+  }
+}
+
+void transformMapToWorld(landmark_map_t& landmarks) {
+  for (auto& el : landmarks) {
+    transformLandmarkToWorld(el.second);
+  }
+}
+
+/// FNV-1a over the raw bytes of a value
+template <typename T>
+void hashBytes(uint64_t& hash, const T& value) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+  for (size_t i = 0; i < sizeof(T); i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+}
+
+uint64_t computeFingerprint(const landmark_map_t& landmarks, LANDMARK_FAMILY family) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hashBytes(hash, family);
+  for (auto& el : landmarks) {
+    hashBytes(hash, el.first);
+    hashBytes(hash, el.second.pose);
+    hashBytes(hash, el.second.points.size());
+    for (auto& pt : el.second.points) {
+      hashBytes(hash, pt);
+    }
+  }
+  return hash;
+}
+
+bool isEqual(const Landmark& a, const Landmark& b) {
+  return a.pose == b.pose && a.points.size() == b.points.size() &&
+         std::equal(a.points.begin(), a.points.end(), b.points.begin());
+}
+
+}  // namespace
+
+LandmarkMap::LandmarkMap(const std::string& mapfile, LANDMARK_FAMILY family) : family_(family) {
+  if (isBinaryMap(mapfile)) {
+    // World points and layout are stored in the file already
+    BinaryMap map(mapfile);
+    family_ = map.getFamily();
+    map.toLandmarkMap(landmarks_);
+    world_landmarks_ = landmarks_;
+    for (const BinaryMapLandmark& lm : map) {
+      const Point* world_points = map.getWorldPoints(lm);
+      world_landmarks_[lm.id].points.assign(world_points, world_points + lm.point_count);
+    }
+  } else {
+    readMapConfig(mapfile, landmarks_, family);
+    world_landmarks_ = landmarks_;
+    transformMapToWorld(world_landmarks_);
+  }
+  Init();
+}
+
+LandmarkMap::LandmarkMap(landmark_map_t landmarks, LANDMARK_FAMILY family)
+    : landmarks_(std::move(landmarks)), world_landmarks_(landmarks_), family_(family) {
+  transformMapToWorld(world_landmarks_);
+  Init();
+}
+
+bool LandmarkMap::contains(landmark_id_t id) const {
+  return std::binary_search(ids_.begin(), ids_.end(), id);
+}
+
+LandmarkMapHandle::LandmarkMapHandle(LandmarkMap::ConstPtr map)
+    : map_(std::move(map)), generation_(1) {}
+
+void LandmarkMapHandle::Publish(LandmarkMap::ConstPtr map) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_.swap(map);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+  // map holds the previous snapshot now. It gets destroyed here, unless a component still uses it.
+}
+
+LandmarkMap::ConstPtr LandmarkMapHandle::Load() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return map_;
+}
+
+bool LandmarkMapHandle::Update(LandmarkMap::ConstPtr& snapshot, uint64_t& generation) const {
+  if (generation_.load(std::memory_order_acquire) == generation) {
+    return false;
+  }
+  LandmarkMap::ConstPtr map;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    map = map_;
+    generation = generation_.load(std::memory_order_relaxed);
+  }
+  snapshot.swap(map);
+  return true;
+}
+
+void LandmarkMap::getVisibleLandmarks(const pose_t& camera_pose,
+                                      const camera_params_t& camera_intrinsics,
+                                      int image_width,
+                                      int image_height,
+                                      std::vector<landmark_id_t>& ids) const {
+  const double fu = camera_intrinsics[(int)INTRINSICS::fu];
+  const double fv = camera_intrinsics[(int)INTRINSICS::fv];
+  const double u0 = camera_intrinsics[(int)INTRINSICS::u0];
+  const double v0 = camera_intrinsics[(int)INTRINSICS::v0];
+  const double* const rotation = &camera_pose[(int)POSE::Rx];
+
+  /// Intersect the rays through the image corners with the lowest and the highest landmark
+  /// plane. The bounding box of these intersections contains the frustum between both planes.
+  double x_min = std::numeric_limits<double>::max();
+  double y_min = std::numeric_limits<double>::max();
+  double x_max = std::numeric_limits<double>::lowest();
+  double y_max = std::numeric_limits<double>::lowest();
+  bool is_bounded = true;
+  for (const double u : {0., static_cast<double>(image_width)}) {
+    for (const double v : {0., static_cast<double>(image_height)}) {
+      const double ray_camera[3] = {(u - u0) / fu, (v - v0) / fv, 1.};
+      double ray[3];
+      ceres::AngleAxisRotatePoint(rotation, ray_camera, ray);
+      if (ray[2] <= std::numeric_limits<double>::epsilon()) {
+        // Ray does not hit the landmark planes (e.g. camera looking sideways)
+        is_bounded = false;
+        continue;
+      }
+      for (const double z : {min_height_, max_height_}) {
+        const double t = std::max(0., (z - camera_pose[(int)POSE::Z]) / ray[2]);
+        x_min = std::min(x_min, camera_pose[(int)POSE::X] + t * ray[0]);
+        y_min = std::min(y_min, camera_pose[(int)POSE::Y] + t * ray[1]);
+        x_max = std::max(x_max, camera_pose[(int)POSE::X] + t * ray[0]);
+        y_max = std::max(y_max, camera_pose[(int)POSE::Y] + t * ray[1]);
+      }
+    }
+  }
+  if (is_bounded) {
+    grid_.QueryBox(x_min, y_min, x_max, y_max, ids);
+  } else {
+    ids = ids_;
+  }
+
+  /// Keep candidates with at least one point in front of the camera and inside the image
+  const double inverse_rotation[3] = {-rotation[0], -rotation[1], -rotation[2]};
+  auto is_visible = [&](landmark_id_t id) {
+    for (auto& pt : world_landmarks_.at(id).points) {
+      const double p_world[3] = {pt[(int)POINT::X] - camera_pose[(int)POSE::X],
+                                 pt[(int)POINT::Y] - camera_pose[(int)POSE::Y],
+                                 pt[(int)POINT::Z] - camera_pose[(int)POSE::Z]};
+      double p_camera[3];
+      ceres::AngleAxisRotatePoint(inverse_rotation, p_world, p_camera);
+      if (p_camera[2] <= 0.) {
+        continue;
+      }
+      const double u = fu * p_camera[0] / p_camera[2] + u0;
+      const double v = fv * p_camera[1] / p_camera[2] + v0;
+      if (u >= 0. && u < image_width && v >= 0. && v < image_height) {
+        return true;
+      }
+    }
+    return false;
+  };
+  ids.erase(
+      std::remove_if(ids.begin(), ids.end(), [&](landmark_id_t id) { return !is_visible(id); }),
+      ids.end());
+}
+
+LandmarkMap::ConstPtr LandmarkMap::Apply(const LandmarkMapDelta& delta) const {
+  // Copies all landmarks, so applying a delta is linear in the size of the map
+  auto map = std::make_shared<LandmarkMap>(*this);
+
+  /// Landmarks with their previous world points, whose grid entries become invalid
+  landmark_map_t erased;
+  for (landmark_id_t id : delta.removed) {
+    if (map->landmarks_.erase(id) > 0) {
+      erased.insert(*map->world_landmarks_.find(id));
+      map->world_landmarks_.erase(id);
+    }
+  }
+  landmark_map_t inserted;
+  for (auto& el : delta.changed) {
+    auto it = world_landmarks_.find(el.first);
+    if (it != world_landmarks_.end()) {
+      erased.insert(*it);
+    }
+    map->landmarks_[el.first] = el.second;
+    Landmark& world_lm = inserted[el.first] = el.second;
+    transformLandmarkToWorld(world_lm);
+    map->world_landmarks_[el.first] = world_lm;
+  }
+
+  /// Heights only have to be searched again, if an extreme point has been erased
+  bool is_extreme_erased = false;
+  for (auto& el : erased) {
+    for (auto& pt : el.second.points) {
+      is_extreme_erased |= pt[(int)POINT::Z] <= min_height_ || pt[(int)POINT::Z] >= max_height_;
+    }
+  }
+  map->ids_.clear();
+  map->max_point_count_ = 0;
+  for (auto& el : map->world_landmarks_) {
+    map->ids_.push_back(el.first);
+    map->max_point_count_ = std::max(map->max_point_count_, el.second.points.size());
+  }
+  if (is_extreme_erased) {
+    map->min_height_ = std::numeric_limits<double>::max();
+    map->max_height_ = std::numeric_limits<double>::lowest();
+    for (auto& el : map->world_landmarks_) {
+      for (auto& pt : el.second.points) {
+        map->min_height_ = std::min(map->min_height_, pt[(int)POINT::Z]);
+        map->max_height_ = std::max(map->max_height_, pt[(int)POINT::Z]);
+      }
+    }
+  } else {
+    for (auto& el : inserted) {
+      for (auto& pt : el.second.points) {
+        map->min_height_ = std::min(map->min_height_, pt[(int)POINT::Z]);
+        map->max_height_ = std::max(map->max_height_, pt[(int)POINT::Z]);
+      }
+    }
+  }
+
+  map->fingerprint_ = computeFingerprint(map->landmarks_, map->family_);
+  if (!map->grid_.Update(erased, inserted)) {
+    // Map has grown beyond the grid
+    map->grid_ = LandmarkGrid(map->world_landmarks_);
+  }
+  return map;
+}
+
+LandmarkMapDelta stargazer::computeMapDelta(const landmark_map_t& from, const landmark_map_t& to) {
+  LandmarkMapDelta delta;
+  for (auto& el : from) {
+    if (to.count(el.first) == 0) {
+      delta.removed.push_back(el.first);
+    }
+  }
+  for (auto& el : to) {
+    auto it = from.find(el.first);
+    if (it == from.end() || !isEqual(it->second, el.second)) {
+      delta.changed.insert(el);
+    }
+  }
+  return delta;
+}
+
+void stargazer::applyMapDelta(landmark_map_t& landmarks, const LandmarkMapDelta& delta) {
+  for (landmark_id_t id : delta.removed) {
+    landmarks.erase(id);
+  }
+  for (auto& el : delta.changed) {
+    landmarks[el.first] = el.second;
+  }
+}
+
+void LandmarkMap::Init() {
+  // landmark_map_t is ordered, so the ids end up sorted
+  ids_.clear();
+  ids_.reserve(world_landmarks_.size());
+  max_point_count_ = 0;
+  min_height_ = std::numeric_limits<double>::max();
+  max_height_ = std::numeric_limits<double>::lowest();
+  for (auto& el : world_landmarks_) {
+    ids_.push_back(el.first);
+    max_point_count_ = std::max(max_point_count_, el.second.points.size());
+    for (auto& pt : el.second.points) {
+      min_height_ = std::min(min_height_, pt[(int)POINT::Z]);
+      max_height_ = std::max(max_height_, pt[(int)POINT::Z]);
+    }
+  }
+  fingerprint_ = computeFingerprint(landmarks_, family_);
+  grid_ = LandmarkGrid(world_landmarks_);
+}
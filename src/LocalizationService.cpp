@@ -0,0 +1,133 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "LocalizationService.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace stargazer;
+
+LocalizationService::LocalizationService(LandmarkMapHandle::Ptr map_handle, size_t thread_count)
+    : finder_(std::move(map_handle)), pool_(thread_count) {}
+
+LocalizationService::~LocalizationService() { Stop(); }
+
+size_t LocalizationService::AddStream(std::unique_ptr<Localizer> localizer,
+                                      ResultCallback callback,
+                                      size_t queue_size) {
+  if (!localizer) {
+    throw std::invalid_argument("LocalizationService needs a Localizer for every stream");
+  }
+  std::lock_guard<std::mutex> lock(streams_mutex_);
+  const size_t index = streams_.size();
+  streams_.emplace_back(new Stream(index, std::move(localizer), std::move(callback), queue_size));
+  return index;
+}
+
+uint64_t LocalizationService::Push(size_t stream_index, const cv::Mat& img, float dt) {
+  Stream& stream = getStream(stream_index);
+  {
+    std::lock_guard<std::mutex> lock(stream.error_mutex);
+    if (stream.error) {
+      std::rethrow_exception(stream.error);
+    }
+  }
+  if (!pool_.isRunning()) {
+    throw std::runtime_error("LocalizationService has been stopped");
+  }
+
+  Frame frame;
+  frame.frame_id = stream.next_frame_id.fetch_add(1, std::memory_order_relaxed);
+  frame.img = img;
+  frame.dt = dt;
+  const uint64_t frame_id = frame.frame_id;
+  while (!stream.frames.TryPush(frame)) {
+    // Make room by discarding the oldest frame, unless the worker was faster
+    Frame dropped;
+    if (stream.frames.TryPop(dropped)) {
+      stream.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  // Pairs with the fence in Process: either the worker sees the frame, or we see it has finished
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!Schedule(stream)) {
+    throw std::runtime_error("LocalizationService has been stopped");
+  }
+  return frame_id;
+}
+
+uint64_t LocalizationService::getDroppedCount(size_t stream) const {
+  return getStream(stream).dropped.load(std::memory_order_relaxed);
+}
+
+LocalizationService::Stream& LocalizationService::getStream(size_t stream) const {
+  std::lock_guard<std::mutex> lock(streams_mutex_);
+  if (stream >= streams_.size()) {
+    throw std::out_of_range("Unknown localization stream " + std::to_string(stream));
+  }
+  return *streams_[stream];
+}
+
+bool LocalizationService::Schedule(Stream& stream) {
+  if (stream.is_scheduled.exchange(true)) {
+    return true;
+  }
+  if (!pool_.TrySubmit([this, &stream]() { Process(stream); })) {
+    stream.is_scheduled.store(false);
+    return false;
+  }
+  return true;
+}
+
+void LocalizationService::Process(Stream& stream) {
+  Frame frame;
+  if (stream.frames.TryPop(frame)) {
+    try {
+      Result result;
+      result.stream = stream.index;
+      result.frame_id = frame.frame_id;
+      if (finder_.DetectLandmarks(frame.img, result.landmarks, stream.workspace) < 0) {
+        throw std::runtime_error("LocalizationService could not detect landmarks: invalid image");
+      }
+      stream.localizer->UpdatePose(result.landmarks, frame.dt, stream.workspace.map);
+      result.pose = stream.localizer->getPose();
+      // The last pose narrows the candidate IDs of the next frame, if a visibility table is set
+      if (result.landmarks.empty()) {
+        stream.workspace.ClearPositionHint();
+      } else {
+        stream.workspace.SetPositionHint(result.pose[(int)POSE::X], result.pose[(int)POSE::Y]);
+      }
+      if (stream.callback) {
+        stream.callback(result);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(stream.error_mutex);
+      if (!stream.error) {
+        stream.error = std::current_exception();
+      }
+    }
+  }
+
+  stream.is_scheduled.store(false);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!stream.frames.empty()) {
+    // Queue up behind the other streams. Once stopped, the remaining frames are discarded.
+    Schedule(stream);
+  }
+}
@@ -0,0 +1,142 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "PosePublisher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace stargazer;
+
+namespace {
+
+constexpr char kPoseSegmentMagic[8] = {'S', 'G', 'Z', 'P', 'O', 'S', 'E', '\0'};
+constexpr uint32_t kPoseSegmentVersion = 1;
+
+}  // namespace
+
+/**
+ * @brief Layout of the published pose, in process memory or in the shared memory segment
+ */
+struct PosePublisher::Segment {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  SeqLock<PoseSnapshot> snapshot;
+
+  Segment() : version(kPoseSegmentVersion), size(sizeof(Segment)) {
+    std::memcpy(magic, kPoseSegmentMagic, sizeof(kPoseSegmentMagic));
+  }
+};
+
+PosePublisher::PosePublisher() : local_(new Segment) {
+  segment_ = local_.get();
+}
+
+PosePublisher::PosePublisher(const std::string& shm_name) : shm_name_(shm_name) {
+  // Exclusive, so a second publisher can neither reset nor later unlink the segment of the first
+  const int fd = ::shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    if (errno == EEXIST) {
+      throw std::runtime_error("Stargazer pose segment is in use already: " + shm_name);
+    }
+    throw std::runtime_error("Could not create stargazer pose segment: " + shm_name);
+  }
+  if (::ftruncate(fd, sizeof(Segment)) != 0) {
+    ::close(fd);
+    ::shm_unlink(shm_name.c_str());
+    throw std::runtime_error("Could not resize stargazer pose segment: " + shm_name);
+  }
+  void* data = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);  // The mapping stays valid after closing the descriptor
+  if (data == MAP_FAILED) {
+    ::shm_unlink(shm_name.c_str());
+    throw std::runtime_error("Could not map stargazer pose segment: " + shm_name);
+  }
+  segment_ = new (data) Segment;
+}
+
+PosePublisher::~PosePublisher() {
+  if (!shm_name_.empty()) {
+    ::munmap(segment_, sizeof(Segment));
+    ::shm_unlink(shm_name_.c_str());
+  }
+}
+
+void PosePublisher::Publish(const PoseSnapshot& snapshot) {
+  segment_->snapshot.Store(snapshot);
+}
+
+bool PosePublisher::TryRead(PoseSnapshot& snapshot) const {
+  return segment_->snapshot.TryLoad(snapshot);
+}
+
+PoseSnapshot PosePublisher::Read() const {
+  return segment_->snapshot.Load();
+}
+
+uint64_t PosePublisher::getVersion() const {
+  return segment_->snapshot.getVersion();
+}
+
+PoseReader::PoseReader(const std::string& shm_name) {
+  // Mapped writable, as atomic loads are not guaranteed to work on read-only pages
+  const int fd = ::shm_open(shm_name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    throw std::runtime_error("Stargazer pose segment does not exist: " + shm_name);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PosePublisher::Segment)) {
+    ::close(fd);
+    throw std::runtime_error("Stargazer pose segment is truncated: " + shm_name);
+  }
+  void* data = ::mmap(nullptr, sizeof(PosePublisher::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("Could not map stargazer pose segment: " + shm_name);
+  }
+  segment_ = static_cast<const PosePublisher::Segment*>(data);
+  if (std::memcmp(segment_->magic, kPoseSegmentMagic, sizeof(kPoseSegmentMagic)) != 0 ||
+      segment_->version != kPoseSegmentVersion || segment_->size != sizeof(PosePublisher::Segment)) {
+    ::munmap(data, sizeof(PosePublisher::Segment));
+    throw std::runtime_error("Stargazer pose segment is invalid: " + shm_name);
+  }
+}
+
+PoseReader::~PoseReader() {
+  ::munmap(const_cast<PosePublisher::Segment*>(segment_), sizeof(PosePublisher::Segment));
+}
+
+bool PoseReader::TryRead(PoseSnapshot& snapshot) const {
+  return segment_->snapshot.TryLoad(snapshot);
+}
+
+PoseSnapshot PoseReader::Read() const {
+  return segment_->snapshot.Load();
+}
+
+uint64_t PoseReader::getVersion() const {
+  return segment_->snapshot.getVersion();
+}
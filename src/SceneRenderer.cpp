@@ -0,0 +1,177 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SceneRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include <ceres/rotation.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "CoordinateTransformations.h"
+#include "internal/ConfigWriter.h"
+
+using namespace stargazer;
+
+SceneRenderer::SceneRenderer(LandmarkMap::ConstPtr map,
+                             const camera_params_t& camera_intrinsics,
+                             const Options& options)
+    : map_(std::move(map)), camera_intrinsics_(camera_intrinsics), options_(options), rng_(options.seed) {}
+
+SceneFrame SceneRenderer::Render(const pose_t& camera_pose) {
+  SceneFrame frame;
+  frame.pose = camera_pose;
+  cv::Mat image(options_.imageHeight, options_.imageWidth, CV_32FC1, cv::Scalar(options_.backgroundIntensity));
+
+  std::vector<landmark_id_t> ids;
+  map_->getVisibleLandmarks(camera_pose, camera_intrinsics_, options_.imageWidth, options_.imageHeight, ids);
+
+  std::bernoulli_distribution is_dark(options_.dropoutProbability);
+  const double inverse_rotation[3] = {-camera_pose[(int)POSE::Rx], -camera_pose[(int)POSE::Ry],
+                                      -camera_pose[(int)POSE::Rz]};
+  for (const landmark_id_t id : ids) {
+    const Landmark& lm = map_->getLandmarks().at(id);
+    ImgLandmark img_lm;
+    img_lm.nID = id;
+    bool is_complete = true;
+    for (size_t k = 0; k < lm.points.size(); k++) {
+      const Point& pt = lm.points[k];
+
+      /// distance along the optical axis, sets the size of the spot
+      double p_world[3];
+      transformLandMarkToWorld(pt[(int)POINT::X], pt[(int)POINT::Y], lm.pose.data(),
+                               &p_world[0], &p_world[1], &p_world[2]);
+      p_world[0] -= camera_pose[(int)POSE::X];
+      p_world[1] -= camera_pose[(int)POSE::Y];
+      p_world[2] -= camera_pose[(int)POSE::Z];
+      double p_camera[3];
+      ceres::AngleAxisRotatePoint(inverse_rotation, p_world, p_camera);
+      if (p_camera[2] <= 0.) {
+        is_complete = false;
+        continue;
+      }
+
+      double u, v;
+      transformLandMarkToImage(pt[(int)POINT::X], pt[(int)POINT::Y], lm.pose.data(), camera_pose.data(),
+                               camera_intrinsics_.data(), &u, &v);
+      if (is_dark(rng_)) {
+        is_complete = false;
+        continue;
+      }
+      const double radius = camera_intrinsics_[(int)INTRINSICS::fu] * options_.ledRadius / p_camera[2];
+      DrawSpot(image, u, v, radius, options_.ledIntensity);
+
+      const ImgPoint pixel(cvRound(u), cvRound(v));
+      if (pixel.x < 0 || pixel.y < 0 || pixel.x >= options_.imageWidth || pixel.y >= options_.imageHeight) {
+        is_complete = false;
+      } else if (k < 3) {
+        img_lm.corners[k] = pixel;
+      } else if (img_lm.idPoints.size() < ImgLandmark::kMaxIdPoints) {
+        img_lm.idPoints.push_back(pixel);
+      }
+    }
+    if (is_complete) {
+      frame.landmarks.push_back(img_lm);
+    }
+  }
+
+  /// distractors, e.g. reflections of lamps on walls or shiny surfaces
+  std::uniform_real_distribution<double> u_dist(0., options_.imageWidth);
+  std::uniform_real_distribution<double> v_dist(0., options_.imageHeight);
+  std::uniform_real_distribution<double> radius_dist(1., std::max(1., options_.reflectionRadius));
+  std::uniform_real_distribution<double> intensity_dist(0.3, 1.);
+  for (int i = 0; i < options_.reflectionCount; i++) {
+    const double u = u_dist(rng_);
+    const double v = v_dist(rng_);
+    const double radius = radius_dist(rng_);
+    DrawSpot(image, u, v, radius, intensity_dist(rng_) * options_.ledIntensity);
+  }
+
+  if (options_.blurSigma > 0.) {
+    cv::GaussianBlur(image, image, cv::Size(0, 0), options_.blurSigma);
+  }
+  if (options_.noiseSigma > 0.) {
+    std::normal_distribution<float> noise(0.f, static_cast<float>(options_.noiseSigma));
+    for (int row = 0; row < image.rows; row++) {
+      float* pixels = image.ptr<float>(row);
+      for (int col = 0; col < image.cols; col++) {
+        pixels[col] += noise(rng_);
+      }
+    }
+  }
+  image.convertTo(frame.image, CV_8UC1);  // Saturates
+  return frame;
+}
+
+std::vector<SceneFrame> SceneRenderer::Render(const std::vector<pose_t>& trajectory) {
+  std::vector<SceneFrame> frames;
+  frames.reserve(trajectory.size());
+  for (const pose_t& pose : trajectory) {
+    frames.push_back(Render(pose));
+  }
+  return frames;
+}
+
+void SceneRenderer::DrawSpot(cv::Mat& image, double u, double v, double radius, double intensity) {
+  /// anti-aliased disc of full intensity, surrounded by a halo, that fades out at three radii
+  const double reach = 3. * radius + 1.;
+  const int row_min = std::max(0, static_cast<int>(std::floor(v - reach)));
+  const int row_max = std::min(image.rows - 1, static_cast<int>(std::ceil(v + reach)));
+  const int col_min = std::max(0, static_cast<int>(std::floor(u - reach)));
+  const int col_max = std::min(image.cols - 1, static_cast<int>(std::ceil(u + reach)));
+  for (int row = row_min; row <= row_max; row++) {
+    float* pixels = image.ptr<float>(row);
+    for (int col = col_min; col <= col_max; col++) {
+      const double d = std::hypot(col - u, row - v);
+      const double core = std::clamp(radius + 0.5 - d, 0., 1.);
+      const double halo = 0.3 * std::exp(-0.5 * (d / radius) * (d / radius));
+      pixels[col] += static_cast<float>(intensity * std::max(core, halo));
+    }
+  }
+}
+
+void stargazer::writeSceneFrames(const std::string& directory, const std::vector<SceneFrame>& frames) {
+  ConfigWriter fout;
+  fout << "Frames:\n";
+  for (size_t i = 0; i < frames.size(); i++) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05zu.png", i);
+    if (!cv::imwrite(directory + "/" + name, frames[i].image)) {
+      throw std::runtime_error("Could not write synthetic image: " + directory + "/" + name);
+    }
+    const pose_t& pose = frames[i].pose;
+    fout << " - { Image: " << name;
+    fout << ", x: " << pose[(int)POSE::X];
+    fout << ", y: " << pose[(int)POSE::Y];
+    fout << ", z: " << pose[(int)POSE::Z];
+    fout << ", rx: " << pose[(int)POSE::Rx];
+    fout << ", ry: " << pose[(int)POSE::Ry];
+    fout << ", rz: " << pose[(int)POSE::Rz];
+    fout << ", HexIDs: [";
+    for (size_t n = 0; n < frames[i].landmarks.size(); n++) {
+      fout << (n == 0 ? "" : ", ");
+      fout.AppendHexId(frames[i].landmarks[n].nID);
+    }
+    fout << "] }\n";
+  }
+  fout.Write(directory + "/groundtruth.yaml");
+}
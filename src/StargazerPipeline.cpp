@@ -0,0 +1,181 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "StargazerPipeline.h"
+
+#include <stdexcept>
+
+#include "Tracer.h"
+
+using namespace stargazer;
+
+StargazerPipeline::StargazerPipeline(std::unique_ptr<LandmarkFinder> finder,
+                                     std::unique_ptr<Localizer> localizer,
+                                     size_t queue_size,
+                                     QUEUE_POLICY policy)
+    : finder_(std::move(finder)),
+      localizer_(std::move(localizer)),
+      policy_(policy),
+      frames_(queue_size),
+      detections_(queue_size),
+      results_(queue_size) {
+  if (!finder_ || !localizer_) {
+    throw std::invalid_argument("StargazerPipeline needs a LandmarkFinder and a Localizer");
+  }
+  detection_thread_ = std::thread(&StargazerPipeline::RunDetection, this);
+  localization_thread_ = std::thread(&StargazerPipeline::RunLocalization, this);
+}
+
+StargazerPipeline::~StargazerPipeline() { Stop(); }
+
+uint64_t StargazerPipeline::Push(const cv::Mat& img, float dt) {
+  RethrowError();
+  // The number is only used up by an accepted frame, so rejected frames leave no gaps
+  std::lock_guard<std::mutex> lock(push_mutex_);
+  Frame frame;
+  frame.frame_id = next_frame_id_;
+  frame.img = img;
+  frame.dt = dt;
+  // A stopped pipeline would still accept frames as long as the queue has room
+  if (!is_running_.load(std::memory_order_acquire) || !Enqueue(frames_, frame, "Frame queue")) {
+    RethrowError();
+    throw std::runtime_error("StargazerPipeline has been stopped");
+  }
+  return next_frame_id_++;
+}
+
+bool StargazerPipeline::PopResult(Result& result, bool wait) {
+  Backoff backoff;
+  while (!results_.TryPop(result)) {
+    RethrowError();
+    if (!wait || !is_running_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    backoff.Wait();
+  }
+  Tracer::AsyncEnd("Result queue", result.frame_id);
+  return true;
+}
+
+void StargazerPipeline::Stop() {
+  is_running_.store(false, std::memory_order_release);
+  if (detection_thread_.joinable()) {
+    detection_thread_.join();
+  }
+  if (localization_thread_.joinable()) {
+    localization_thread_.join();
+  }
+}
+
+void StargazerPipeline::RunDetection() {
+  Tracer::SetThreadName("Detection");
+  Backoff backoff;
+  Frame frame;
+  while (is_running_.load(std::memory_order_acquire)) {
+    if (!frames_.TryPop(frame)) {
+      backoff.Wait();
+      continue;
+    }
+    backoff.Reset();
+    Tracer::AsyncEnd("Frame queue", frame.frame_id);
+
+    Detection detection;
+    detection.frame_id = frame.frame_id;
+    detection.dt = frame.dt;
+    try {
+      if (finder_->DetectLandmarks(frame.img, detection.landmarks) < 0) {
+        throw std::runtime_error("StargazerPipeline could not detect landmarks: invalid image");
+      }
+      detection.map = finder_->getMap();
+    } catch (...) {
+      Fail(std::current_exception());
+      return;
+    }
+    frame.img.release();
+    Enqueue(detections_, detection, "Detection queue");
+  }
+}
+
+void StargazerPipeline::RunLocalization() {
+  Tracer::SetThreadName("Localization");
+  Backoff backoff;
+  Detection detection;
+  while (is_running_.load(std::memory_order_acquire)) {
+    if (!detections_.TryPop(detection)) {
+      backoff.Wait();
+      continue;
+    }
+    backoff.Reset();
+    Tracer::AsyncEnd("Detection queue", detection.frame_id);
+
+    Result result;
+    result.frame_id = detection.frame_id;
+    try {
+      localizer_->UpdatePose(detection.landmarks, detection.dt, detection.map);
+    } catch (...) {
+      Fail(std::current_exception());
+      return;
+    }
+    result.pose = localizer_->getPose();
+    result.landmarks = std::move(detection.landmarks);
+    Enqueue(results_, result, "Result queue");
+  }
+}
+
+template <typename T>
+bool StargazerPipeline::Enqueue(BoundedQueue<T>& queue, T& value, const char* trace_name) {
+  Tracer::AsyncBegin(trace_name, value.frame_id);
+  Backoff backoff;
+  while (!queue.TryPush(value)) {
+    if (!is_running_.load(std::memory_order_acquire)) {
+      Tracer::AsyncEnd(trace_name, value.frame_id);
+      return false;
+    }
+    if (policy_ == QUEUE_POLICY::DROP_OLDEST) {
+      // Make room by discarding the oldest element, unless a consumer was faster
+      T dropped;
+      if (queue.TryPop(dropped)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        Tracer::AsyncEnd(trace_name, dropped.frame_id);
+      }
+    } else {
+      backoff.Wait();
+    }
+  }
+  return true;
+}
+
+void StargazerPipeline::Fail(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (!error_) {
+      error_ = error;
+    }
+  }
+  is_running_.store(false, std::memory_order_release);
+}
+
+void StargazerPipeline::RethrowError() {
+  if (is_running_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
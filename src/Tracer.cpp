@@ -0,0 +1,249 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "Tracer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace stargazer;
+
+namespace {
+
+typedef std::chrono::steady_clock clock;
+
+struct TraceEvent {
+  const char* name;   /**< Stage or interval name */
+  uint64_t timestamp; /**< Nanoseconds since the clock's epoch */
+  uint64_t id;        /**< Interval id of async events */
+  char phase;         /**< Chrome trace event type */
+};
+
+/**
+ * @brief Events of a single thread. Only the owning thread appends, count publishes them.
+ */
+struct ThreadBuffer {
+  ThreadBuffer(size_t capacity_, uint32_t tid_) : events(new TraceEvent[capacity_]), capacity(capacity_), tid(tid_) {}
+
+  std::unique_ptr<TraceEvent[]> events; /**< Storage, guarded by Registry::mutex once the thread ended */
+  size_t capacity;                      /**< Maximum number of events */
+  std::atomic<size_t> count{0};         /**< Number of recorded events */
+  const uint32_t tid;                   /**< Thread id in the trace */
+  std::string name;                     /**< Thread name, guarded by Registry::mutex */
+};
+
+struct Registry {
+  std::mutex mutex;                                   /**< Guards buffers and thread names */
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers; /**< Buffers of all threads ever recording */
+  std::atomic<size_t> capacity{1 << 16};              /**< Capacity of new buffers */
+  std::atomic<uint64_t> dropped{0};                   /**< Events that did not fit */
+  std::string exit_tracefile;                         /**< Trace file written on exit */
+  std::once_flag exit_handler;                        /**< Registers the exit handler once */
+  const clock::time_point origin = clock::now();      /**< Time zero of the trace */
+};
+
+/// The registry is never destroyed, so threads and exit handlers can use it until the very end
+Registry& registry() {
+  static Registry* const instance = new Registry;
+  return *instance;
+}
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+/**
+ * @brief Shrinks the buffer of a thread to its recorded events, when the thread ends. Otherwise
+ * short-lived threads, e.g. of LandmarkFinder::DetectLandmarksBatch, would pile up full-size
+ * buffers. Events recorded after this are dropped.
+ */
+struct ThreadBufferRelease {
+  ~ThreadBufferRelease() {
+    if (!t_buffer) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    const size_t count = t_buffer->count.load(std::memory_order_relaxed);
+    std::unique_ptr<TraceEvent[]> events(count > 0 ? new TraceEvent[count] : nullptr);
+    std::copy(t_buffer->events.get(), t_buffer->events.get() + count, events.get());
+    t_buffer->events.swap(events);
+    t_buffer->capacity = count;
+  }
+};
+
+ThreadBuffer& threadBuffer() {
+  if (!t_buffer) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.buffers.emplace_back(new ThreadBuffer(reg.capacity.load(), static_cast<uint32_t>(reg.buffers.size() + 1)));
+    t_buffer = reg.buffers.back().get();
+    thread_local ThreadBufferRelease release;
+  }
+  return *t_buffer;
+}
+
+/// JSON string literal, control characters are written as \u escapes
+void appendString(std::string& json, const char* text) {
+  json += '"';
+  for (const char* c = text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      json += '\\';
+      json += *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      static const char kHexDigits[] = "0123456789abcdef";
+      json += "\\u00";
+      json += kHexDigits[(*c >> 4) & 0xf];
+      json += kHexDigits[*c & 0xf];
+    } else {
+      json += *c;
+    }
+  }
+  json += '"';
+}
+
+/// Shortest round-trip representation, independent of the locale
+void appendNumber(std::string& json, double value) {
+  char buffer[32];
+  const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  json.append(buffer, result.ptr);
+}
+
+void appendInteger(std::string& json, uint64_t value, int base = 10) {
+  char buffer[24];
+  const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, base);
+  json.append(buffer, result.ptr);
+}
+
+void writeOnExit() {
+  std::string tracefile;
+  {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    tracefile = registry().exit_tracefile;
+  }
+  try {
+    Tracer::Write(tracefile);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+
+void Tracer::Enable(size_t events_per_thread) {
+  registry().capacity.store(events_per_thread);
+  enabled_.store(true);
+}
+
+void Tracer::Disable() { enabled_.store(false); }
+
+void Tracer::SetThreadName(const std::string& name) {
+  ThreadBuffer& buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  buffer.name = name;
+}
+
+void Tracer::Record(const char* name, char phase, uint64_t id) {
+  ThreadBuffer& buffer = threadBuffer();
+  const size_t count = buffer.count.load(std::memory_order_relaxed);
+  if (count >= buffer.capacity) {
+    registry().dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t timestamp = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count());
+  buffer.events[count] = TraceEvent{name, timestamp, id, phase};
+  buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::Write(const std::string& tracefile) {
+  Registry& reg = registry();
+  const uint64_t origin = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(reg.origin.time_since_epoch()).count());
+  const uint64_t pid = static_cast<uint64_t>(::getpid());
+
+  std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool is_first = true;
+  {
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+      if (!buffer->name.empty()) {
+        json += is_first ? "" : ",\n";
+        json += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": ";
+        appendInteger(json, pid);
+        json += ", \"tid\": ";
+        appendInteger(json, buffer->tid);
+        json += ", \"args\": {\"name\": ";
+        appendString(json, buffer->name.c_str());
+        json += "}}";
+        is_first = false;
+      }
+      const size_t count = buffer->count.load(std::memory_order_acquire);
+      for (size_t i = 0; i < count; i++) {
+        const TraceEvent& event = buffer->events[i];
+        json += is_first ? "" : ",\n";
+        json += "{\"name\": ";
+        appendString(json, event.name);
+        json += ", \"cat\": \"stargazer\", \"ph\": \"";
+        json += event.phase;
+        json += "\", \"ts\": ";
+        appendNumber(json, static_cast<double>(event.timestamp - origin) * 1e-3);
+        json += ", \"pid\": ";
+        appendInteger(json, pid);
+        json += ", \"tid\": ";
+        appendInteger(json, buffer->tid);
+        if (event.phase == 'b' || event.phase == 'e') {
+          json += ", \"id\": \"0x";
+          appendInteger(json, event.id, 16);
+          json += '"';
+        }
+        json += '}';
+        is_first = false;
+      }
+    }
+  }
+  json += "\n]}\n";
+
+  std::ofstream fout(tracefile, std::ios::binary);
+  fout.write(json.data(), static_cast<std::streamsize>(json.size()));
+  if (!fout) {
+    throw std::runtime_error("Could not write stargazer trace file: " + tracefile);
+  }
+}
+
+void Tracer::WriteOnExit(const std::string& tracefile) {
+  Registry& reg = registry();
+  {
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.exit_tracefile = tracefile;
+  }
+  std::call_once(reg.exit_handler, []() { std::atexit(writeOnExit); });
+}
+
+uint64_t Tracer::getDroppedCount() { return registry().dropped.load(std::memory_order_relaxed); }
@@ -0,0 +1,234 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "VisibilityTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+using namespace stargazer;
+
+namespace {
+
+constexpr char kVisibilityTableMagic[8] = {'S', 'G', 'Z', 'V', 'I', 'S', '\0', '\0'};
+constexpr uint32_t kVisibilityTableVersion = 3;
+
+struct VisibilityTableHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t cols;
+  int32_t rows;
+  uint32_t id_count;
+  uint64_t map_fingerprint;
+  double cell_size;
+  double x_origin;
+  double y_origin;
+};
+
+}  // namespace
+
+VisibilityTable::VisibilityTable(const LandmarkMap& map,
+                                 const camera_params_t& camera_intrinsics,
+                                 int image_width,
+                                 int image_height,
+                                 double camera_height,
+                                 double cell_size,
+                                 double max_tilt)
+    : map_fingerprint_(map.getFingerprint()), cell_size_(cell_size) {
+  /// Half opening angle of the cone around the optical axis, that contains the whole image
+  double tan_fov = 0.;
+  for (const double u : {0., static_cast<double>(image_width)}) {
+    for (const double v : {0., static_cast<double>(image_height)}) {
+      tan_fov = std::max(tan_fov,
+                         std::hypot((u - camera_intrinsics[(int)INTRINSICS::u0]) /
+                                        camera_intrinsics[(int)INTRINSICS::fu],
+                                    (v - camera_intrinsics[(int)INTRINSICS::v0]) /
+                                        camera_intrinsics[(int)INTRINSICS::fv]));
+    }
+  }
+  // A tilted camera sees points up to this angle from the vertical
+  const double max_angle = std::atan(tan_fov) + max_tilt;
+  if (max_angle >= M_PI_2) {
+    throw std::runtime_error("Field of view is too wide for a visibility table");
+  }
+  const double tan_max_angle = std::tan(max_angle);
+
+  /// Horizontal reach of every point, the camera may be placed within this radius around it
+  struct Reach {
+    double x, y, radius;
+  };
+  std::vector<std::pair<landmark_id_t, std::vector<Reach>>> landmarks;
+  double x_min = std::numeric_limits<double>::max();
+  double y_min = std::numeric_limits<double>::max();
+  double x_max = std::numeric_limits<double>::lowest();
+  double y_max = std::numeric_limits<double>::lowest();
+  for (auto& el : map.getWorldLandmarks()) {
+    std::vector<Reach> reaches;
+    for (auto& pt : el.second.points) {
+      const double dz = pt[(int)POINT::Z] - camera_height;
+      if (dz <= 0.) {
+        continue;  // Camera is looking upwards
+      }
+      Reach reach{pt[(int)POINT::X], pt[(int)POINT::Y], dz * tan_max_angle};
+      x_min = std::min(x_min, reach.x - reach.radius);
+      y_min = std::min(y_min, reach.y - reach.radius);
+      x_max = std::max(x_max, reach.x + reach.radius);
+      y_max = std::max(y_max, reach.y + reach.radius);
+      reaches.push_back(reach);
+    }
+    if (!reaches.empty()) {
+      landmarks.emplace_back(el.first, std::move(reaches));
+    }
+  }
+  if (landmarks.empty()) {
+    cell_offsets_.assign(1, 0);
+    return;
+  }
+  x_origin_ = x_min;
+  y_origin_ = y_min;
+  cols_ = static_cast<int32_t>((x_max - x_min) / cell_size_) + 1;
+  rows_ = static_cast<int32_t>((y_max - y_min) / cell_size_) + 1;
+
+  /// Register every landmark in all cells, that lie within the reach of one of its points. Only
+  /// the bounding box of every reach is visited. landmark_map_t is ordered, so the ids of every
+  /// cell arrive in ascending order, and a landmark reached by several points is the last one.
+  std::vector<std::vector<landmark_id_t>> cells(static_cast<size_t>(cols_) * rows_);
+  for (auto& lm : landmarks) {
+    for (auto& reach : lm.second) {
+      const int col_min = static_cast<int>((reach.x - reach.radius - x_origin_) / cell_size_);
+      const int col_max = static_cast<int>((reach.x + reach.radius - x_origin_) / cell_size_);
+      const int row_min = static_cast<int>((reach.y - reach.radius - y_origin_) / cell_size_);
+      const int row_max = static_cast<int>((reach.y + reach.radius - y_origin_) / cell_size_);
+      for (int row = std::max(row_min, 0); row <= std::min(row_max, rows_ - 1); row++) {
+        for (int col = std::max(col_min, 0); col <= std::min(col_max, cols_ - 1); col++) {
+          // Distance between point and closest position within cell
+          const double cell_x = x_origin_ + col * cell_size_;
+          const double cell_y = y_origin_ + row * cell_size_;
+          const double dx = reach.x - std::clamp(reach.x, cell_x, cell_x + cell_size_);
+          const double dy = reach.y - std::clamp(reach.y, cell_y, cell_y + cell_size_);
+          std::vector<landmark_id_t>& cell = cells[static_cast<size_t>(row) * cols_ + col];
+          if (std::hypot(dx, dy) <= reach.radius && (cell.empty() || cell.back() != lm.first)) {
+            cell.push_back(lm.first);
+          }
+        }
+      }
+    }
+  }
+
+  /// Store cells as compressed rows
+  cell_offsets_.reserve(cells.size() + 1);
+  cell_offsets_.push_back(0);
+  for (auto& cell : cells) {
+    cell_ids_.insert(cell_ids_.end(), cell.begin(), cell.end());
+    cell_offsets_.push_back(static_cast<uint32_t>(cell_ids_.size()));
+  }
+}
+
+VisibilityTable::VisibilityTable(const std::string& tablefile) {
+  std::ifstream fin(tablefile, std::ios::binary | std::ios::ate);
+  if (!fin) {
+    throw std::runtime_error("Stargazer visibility table file does not exist: " + tablefile);
+  }
+  const uint64_t length = static_cast<uint64_t>(fin.tellg());
+  fin.seekg(0);
+  VisibilityTableHeader header;
+  fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!fin || std::memcmp(header.magic, kVisibilityTableMagic, sizeof(kVisibilityTableMagic)) != 0 ||
+      header.version != kVisibilityTableVersion || header.cols < 0 || header.rows < 0) {
+    throw std::runtime_error("Stargazer visibility table file is invalid: " + tablefile);
+  }
+  // Checked before allocating, a corrupt header must not request huge buffers
+  const uint64_t cell_count = static_cast<uint64_t>(header.cols) * static_cast<uint64_t>(header.rows);
+  if ((cell_count + 1 + header.id_count) * sizeof(uint32_t) != length - sizeof(header)) {
+    throw std::runtime_error("Stargazer visibility table file is truncated: " + tablefile);
+  }
+  map_fingerprint_ = header.map_fingerprint;
+  cell_size_ = header.cell_size;
+  x_origin_ = header.x_origin;
+  y_origin_ = header.y_origin;
+  cols_ = header.cols;
+  rows_ = header.rows;
+  cell_offsets_.resize(static_cast<size_t>(cols_) * rows_ + 1);
+  cell_ids_.resize(header.id_count);
+  fin.read(reinterpret_cast<char*>(cell_offsets_.data()), cell_offsets_.size() * sizeof(uint32_t));
+  fin.read(reinterpret_cast<char*>(cell_ids_.data()), cell_ids_.size() * sizeof(landmark_id_t));
+  if (!fin) {
+    throw std::runtime_error("Stargazer visibility table file is truncated: " + tablefile);
+  }
+  // getVisibleIds builds ranges from the offsets without checks, GetIDs binary searches the ids
+  bool is_valid = cell_offsets_.front() == 0 && cell_offsets_.back() == header.id_count &&
+                  std::is_sorted(cell_offsets_.begin(), cell_offsets_.end());
+  for (size_t cell = 0; is_valid && cell + 1 < cell_offsets_.size(); cell++) {
+    is_valid = std::is_sorted(cell_ids_.begin() + cell_offsets_[cell],
+                              cell_ids_.begin() + cell_offsets_[cell + 1]);
+  }
+  if (!is_valid) {
+    throw std::runtime_error("Stargazer visibility table file is corrupt: " + tablefile);
+  }
+}
+
+VisibilityTable::IdRange VisibilityTable::getVisibleIds(double x, double y) const {
+  size_t cell;
+  if (!getCell(x, y, cell)) {
+    return IdRange{nullptr, nullptr};
+  }
+  return IdRange{cell_ids_.data() + cell_offsets_[cell], cell_ids_.data() + cell_offsets_[cell + 1]};
+}
+
+bool VisibilityTable::contains(double x, double y) const {
+  size_t cell;
+  return getCell(x, y, cell);
+}
+
+bool VisibilityTable::getCell(double x, double y, size_t& cell) const {
+  const double col = std::floor((x - x_origin_) / cell_size_);
+  const double row = std::floor((y - y_origin_) / cell_size_);
+  if (!(col >= 0. && row >= 0. && col < cols_ && row < rows_)) {
+    return false;  // Also rejects NaN
+  }
+  cell = static_cast<size_t>(row) * cols_ + static_cast<size_t>(col);
+  return true;
+}
+
+void stargazer::writeVisibilityTable(const std::string& tablefile, const VisibilityTable& table) {
+  VisibilityTableHeader header;
+  std::memcpy(header.magic, kVisibilityTableMagic, sizeof(kVisibilityTableMagic));
+  header.version = kVisibilityTableVersion;
+  header.cols = table.cols_;
+  header.rows = table.rows_;
+  header.id_count = static_cast<uint32_t>(table.cell_ids_.size());
+  header.map_fingerprint = table.map_fingerprint_;
+  header.cell_size = table.cell_size_;
+  header.x_origin = table.x_origin_;
+  header.y_origin = table.y_origin_;
+
+  std::ofstream fout(tablefile, std::ios::binary);
+  if (!fout) {
+    throw std::runtime_error("Could not open stargazer visibility table file for writing: " + tablefile);
+  }
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(reinterpret_cast<const char*>(table.cell_offsets_.data()),
+             table.cell_offsets_.size() * sizeof(uint32_t));
+  fout.write(reinterpret_cast<const char*>(table.cell_ids_.data()),
+             table.cell_ids_.size() * sizeof(landmark_id_t));
+  fout.close();
+}
@@ -0,0 +1,74 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "internal/BoundedQueue.h"
+
+using namespace stargazer;
+
+TEST(BoundedQueue, FullAndEmpty) {
+  BoundedQueue<int> queue(3);
+  ASSERT_EQ(4, queue.capacity());
+
+  int value = 0;
+  ASSERT_TRUE(queue.empty());
+  ASSERT_FALSE(queue.TryPop(value));
+  for (int i = 0; i < 4; i++) {
+    value = i;
+    ASSERT_TRUE(queue.TryPush(value));
+  }
+  value = 4;
+  ASSERT_FALSE(queue.TryPush(value));
+  ASSERT_EQ(4, value);  // Not moved from
+  ASSERT_FALSE(queue.empty());
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.TryPop(value));
+    ASSERT_EQ(i, value);
+  }
+  ASSERT_TRUE(queue.empty());
+  ASSERT_FALSE(queue.TryPop(value));
+}
+
+TEST(BoundedQueue, Threads) {
+  constexpr int kProducers = 4;
+  constexpr int kItems = 10000;
+  BoundedQueue<int> queue(8);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kItems; i++) {
+        int value = p * kItems + i;
+        Backoff backoff;
+        while (!queue.TryPush(value)) {
+          backoff.Wait();
+        }
+      }
+    });
+  }
+
+  // Every item arrives exactly once and items of one producer stay in order
+  std::vector<int> last(kProducers, -1);
+  std::vector<bool> received(kProducers * kItems, false);
+  for (int count = 0; count < kProducers * kItems;) {
+    int value;
+    if (!queue.TryPop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_FALSE(received[value]);
+    received[value] = true;
+    ASSERT_LT(last[value / kItems], value % kItems);
+    last[value / kItems] = value % kItems;
+    count++;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
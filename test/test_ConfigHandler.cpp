@@ -36,6 +36,8 @@
 //	  ASSERT_EQ((10.0f + 2.0f) * 3.0f, 10.0f * 3.0f + 2.0f * 3.0f)
 //}
 //=======================================================================================================================================================
+#include <cmath>
+
 #include "StargazerConfig.h"
 #include "gtest/gtest.h"
 
@@ -72,9 +74,123 @@ TEST(ConfigHandler, Write) {
   ASSERT_NO_THROW(writeMapConfig(map_testfile, landmarks));
   camera_params_t camera_intrinsics_test;
   landmark_map_t landmarks_test;
+  ASSERT_NO_THROW(readCamConfig(cam_testfile, camera_intrinsics_test));
+  ASSERT_NO_THROW(readMapConfig(map_testfile, landmarks_test));
+  ASSERT_EQ(landmarks.size(), landmarks_test.size());
+
+  // Values read back exactly
+  ASSERT_EQ(camera_intrinsics, camera_intrinsics_test);
+  for (auto& el : landmarks) {
+    ASSERT_EQ(el.second.pose, landmarks_test.at(el.first).pose);
+  }
+}
+
+TEST(ConfigHandler, WriteExact) {
+  // Values, that need all 17 digits
+  camera_params_t camera_intrinsics = {{1. / 3., 2. / 3., 1e-300, -123456.78901234567}};
+  landmark_map_t landmarks;
+  landmarks[0x4184] = Landmark(0x4184);
+  landmarks[0x4184].pose = {{0.1 + 0.2, 1. / 7., 1e5 + 1e-9, M_PI, -M_PI_2, 0.}};
+  landmarks[0xFFFFFFFF] = Landmark(0xFFFFFFFF, LANDMARK_FAMILY::GRID_6x6);
+
+  std::string cam_testfile{"res/cam_exact_test.yaml"};
+  std::string map_testfile{"res/map_exact_test.yaml"};
+  // Repeated write/read cycles do not change the values
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NO_THROW(writeCamConfig(cam_testfile, camera_intrinsics));
+    ASSERT_NO_THROW(writeMapConfig(map_testfile, landmarks));
+    camera_params_t camera_intrinsics_test;
+    landmark_map_t landmarks_test;
+    ASSERT_NO_THROW(readCamConfig(cam_testfile, camera_intrinsics_test));
+    ASSERT_NO_THROW(readMapConfig(map_testfile, landmarks_test, LANDMARK_FAMILY::GRID_6x6));
+    ASSERT_EQ(camera_intrinsics, camera_intrinsics_test);
+    ASSERT_EQ(landmarks.size(), landmarks_test.size());
+    for (auto& el : landmarks) {
+      ASSERT_EQ(el.second.pose, landmarks_test.at(el.first).pose);
+    }
+    camera_intrinsics = camera_intrinsics_test;
+  }
+}
+
+void writeFile(const std::string& file, const std::string& content) {
+  std::ofstream fout(file);
+  fout << content;
+}
+
+std::string readMapError(const std::string& content) {
+  const std::string map_testfile{"res/map_error_test.yaml"};
+  writeFile(map_testfile, content);
+  landmark_map_t landmarks;
+  try {
+    readMapConfig(map_testfile, landmarks);
+  } catch (std::runtime_error& e) {
+    return e.what();
+  }
+  return "";
+}
+
+TEST(ConfigHandler, ReadStyles) {
+  // Block style, comments, unknown keys and a sequence indented like its key
+  std::string cam_testfile{"res/cam_style_test.yaml"};
+  writeFile(cam_testfile,
+            "# camera\n"
+            "Version: 2\n"
+            "Calibration:\n"
+            "  date: today\n"
+            "  - unused\n"
+            "CameraIntrinsics: {fu: 1.5, fv: 2, u0: +3e2, v0: '4'}\n");
+  camera_params_t camera_intrinsics;
   ASSERT_NO_THROW(readCamConfig(cam_testfile, camera_intrinsics));
+  ASSERT_EQ(1.5, camera_intrinsics[(int)INTRINSICS::fu]);
+  ASSERT_EQ(300., camera_intrinsics[(int)INTRINSICS::u0]);
+  ASSERT_EQ(4., camera_intrinsics[(int)INTRINSICS::v0]);
+
+  std::string map_testfile{"res/map_style_test.yaml"};
+  writeFile(map_testfile,
+            "Landmarks:\n"
+            "- HexID: 0x0016  # first\n"
+            "  x: 1\n"
+            "  y: 2\n"
+            "  z: 3\n"
+            "  rx: 0\n"
+            "  ry: 0\n"
+            "  rz: 0\n"
+            "\n"
+            "-\n"
+            "    HexID: 134\n"
+            "    x: 1\n"
+            "    y: 2\n"
+            "    z: 3\n"
+            "    rx: 0\n"
+            "    ry: 0\n"
+            "    rz: 0.5\n"
+            "- {HexID: 0xFFFFFFFF, x: 1, y: 2, z: 3, rx: 0, ry: 0, rz: 0}\n");
+  landmark_map_t landmarks;
   ASSERT_NO_THROW(readMapConfig(map_testfile, landmarks));
-  ASSERT_EQ(landmarks.size(), landmarks_test.size());
+  ASSERT_EQ(3, landmarks.size());
+  ASSERT_EQ(0.5, landmarks.at(0x86).pose[(int)POSE::Rz]);
+  ASSERT_EQ(3., landmarks.at(0xFFFFFFFF).pose[(int)POSE::Z]);
+}
+
+TEST(ConfigHandler, ReadErrors) {
+  // Errors are reported with line and column
+  ASSERT_EQ("Error in stargazer config file res/map_error_test.yaml:2:24: Invalid number '1.2.3'",
+            readMapError("Landmarks:\n"
+                         " - { HexID: 0x0016, x: 1.2.3, y: 2, z: 3, rx: 0, ry: 0, rz: 0 }\n"));
+  ASSERT_EQ("Error in stargazer config file res/map_error_test.yaml:3:2: Landmark is missing rz",
+            readMapError("Landmarks:\n"
+                         " - { HexID: 0x0016, x: 1, y: 2, z: 3, rx: 0, ry: 0, rz: 0 }\n"
+                         " - { HexID: 0x0086, x: 1, y: 2, z: 3, rx: 0, ry: 0 }\n"));
+  ASSERT_EQ("Error in stargazer config file res/map_error_test.yaml:2:20: Expected ',' or '}'",
+            readMapError("Landmarks:\n"
+                         " - { HexID: 0x0016 x: 1 }\n"));
+  ASSERT_EQ("Error in stargazer config file res/map_error_test.yaml:2:13: Invalid unsigned integer '-1'",
+            readMapError("Landmarks:\n"
+                         " - { HexID: -1, x: 1, y: 2, z: 3, rx: 0, ry: 0, rz: 0 }\n"));
+  ASSERT_EQ("Error in stargazer config file res/map_error_test.yaml:3:7: Unexpected indentation",
+            readMapError("Landmarks:\n"
+                         "  - HexID: 1\n"
+                         "      x: 1\n"));
 }
 
 int main(int argc, char** argv) {
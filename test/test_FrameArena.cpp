@@ -0,0 +1,44 @@
+#include <memory_resource>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "internal/FrameArena.h"
+
+using namespace stargazer;
+
+TEST(FrameArena, GrowsToPeak) {
+  FrameArena arena(1024);
+  {
+    std::pmr::vector<double> scratch(arena.getResource());
+    scratch.resize(1000);
+    ASSERT_LT(0, arena.getOverflowCount());
+  }
+  arena.Reset();
+  ASSERT_LT(1000 * sizeof(double), arena.getSize());
+
+  // Same demand in steady state is served by the arena alone
+  for (int frame = 0; frame < 3; frame++) {
+    {
+      std::pmr::vector<double> scratch(arena.getResource());
+      scratch.resize(1000);
+    }
+    ASSERT_EQ(0, arena.getOverflowCount());
+    arena.Reset();
+  }
+}
+
+TEST(FrameArena, NestedContainers) {
+  FrameArena arena;
+  std::pmr::vector<std::pmr::vector<int>> clusters(arena.getResource());
+  clusters.emplace_back(3, 1);
+  clusters.emplace_back(2, 2);
+  ASSERT_EQ(arena.getResource(), clusters[0].get_allocator().resource());
+  ASSERT_EQ(3, clusters[0].size());
+  ASSERT_EQ(2, clusters[1][1]);
+  ASSERT_EQ(0, arena.getOverflowCount());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
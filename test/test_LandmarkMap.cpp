@@ -0,0 +1,384 @@
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+
+#include "BinaryMap.h"
+#include "CoordinateTransformations.h"
+#include "LandmarkMap.h"
+#include "StargazerConfig.h"
+#include "VisibilityTable.h"
+#include "gtest/gtest.h"
+
+using namespace stargazer;
+
+TEST(BinaryMap, RoundTrip) {
+  std::string map_cfgfile{"res/map.yaml"};
+  std::string map_binfile{"res/map_test.bin"};
+  std::string map_testfile{"res/map_test_bin.yaml"};
+  landmark_map_t landmarks;
+  ASSERT_NO_THROW(readMapConfig(map_cfgfile, landmarks));
+  ASSERT_NO_THROW(convertMapConfigToBinary(map_cfgfile, map_binfile));
+  ASSERT_NO_THROW(convertBinaryToMapConfig(map_binfile, map_testfile));
+
+  landmark_map_t landmarks_test;
+  ASSERT_NO_THROW(readMapConfig(map_testfile, landmarks_test));
+  ASSERT_EQ(landmarks.size(), landmarks_test.size());
+  for (auto& el : landmarks) {
+    ASSERT_EQ(1, landmarks_test.count(el.first));
+    ASSERT_EQ(el.second.points.size(), landmarks_test[el.first].points.size());
+  }
+}
+
+TEST(BinaryMap, WorldPoints) {
+  std::string map_cfgfile{"res/map.yaml"};
+  std::string map_binfile{"res/map_test.bin"};
+  landmark_map_t landmarks;
+  ASSERT_NO_THROW(readMapConfig(map_cfgfile, landmarks));
+  ASSERT_NO_THROW(writeBinaryMap(map_binfile, landmarks));
+
+  BinaryMap map(map_binfile);
+  ASSERT_EQ(landmarks.size(), map.size());
+  ASSERT_EQ(nullptr, map.find(-1));
+  for (auto& el : landmarks) {
+    const BinaryMapLandmark* lm = map.find(el.first);
+    ASSERT_NE(nullptr, lm);
+    ASSERT_EQ(el.second.points.size(), lm->point_count);
+    for (size_t i = 0; i < el.second.points.size(); i++) {
+      double x, y, z;
+      transformLandMarkToWorld(el.second.points[i][(int)POINT::X],
+                               el.second.points[i][(int)POINT::Y],
+                               el.second.pose.data(),
+                               &x,
+                               &y,
+                               &z);
+      const Point& pt = map.getWorldPoints(*lm)[i];
+      ASSERT_DOUBLE_EQ(x, pt[(int)POINT::X]);
+      ASSERT_DOUBLE_EQ(y, pt[(int)POINT::Y]);
+      ASSERT_DOUBLE_EQ(z, pt[(int)POINT::Z]);
+    }
+  }
+}
+
+TEST(BinaryMap, InvalidFile) {
+  ASSERT_THROW(BinaryMap("res/does_not_exist.bin"), std::runtime_error);
+  ASSERT_THROW(BinaryMap("res/map.yaml"), std::runtime_error);
+}
+
+TEST(BinaryMap, CorruptFile) {
+  std::string map_binfile{"res/map_test.bin"};
+  landmark_map_t landmarks;
+  ASSERT_NO_THROW(readMapConfig("res/map.yaml", landmarks));
+  ASSERT_NO_THROW(writeBinaryMap(map_binfile, landmarks));
+  std::string data;
+  {
+    std::ifstream fin(map_binfile, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+  }
+  auto write_corrupted = [&](const std::function<void(BinaryMapHeader&, BinaryMapLandmark*)>& f) {
+    std::string corrupted = data;
+    BinaryMapHeader& header = *reinterpret_cast<BinaryMapHeader*>(&corrupted[0]);
+    f(header, reinterpret_cast<BinaryMapLandmark*>(&corrupted[header.landmarks_offset]));
+    std::ofstream(map_binfile, std::ios::binary) << corrupted;
+  };
+
+  // Section size overflows
+  write_corrupted([](BinaryMapHeader& header, BinaryMapLandmark*) {
+    header.point_count = std::numeric_limits<uint64_t>::max() / sizeof(Point) + 1;
+  });
+  ASSERT_THROW(BinaryMap{map_binfile}, std::runtime_error);
+
+  // Point range of a landmark exceeds the point section
+  write_corrupted([](BinaryMapHeader& header, BinaryMapLandmark* records) {
+    records[header.landmark_count - 1].first_point = header.point_count - 1;
+  });
+  ASSERT_THROW(BinaryMap{map_binfile}, std::runtime_error);
+  write_corrupted([](BinaryMapHeader&, BinaryMapLandmark* records) {
+    records[0].first_point = std::numeric_limits<uint64_t>::max();
+  });
+  ASSERT_THROW(BinaryMap{map_binfile}, std::runtime_error);
+
+  // Records not sorted by id
+  write_corrupted([](BinaryMapHeader&, BinaryMapLandmark* records) {
+    std::swap(records[0].id, records[1].id);
+  });
+  ASSERT_THROW(BinaryMap{map_binfile}, std::runtime_error);
+
+  write_corrupted([](BinaryMapHeader&, BinaryMapLandmark*) {});
+  ASSERT_NO_THROW(BinaryMap{map_binfile});
+}
+
+TEST(LandmarkMap, LoadBinaryAndYaml) {
+  std::string map_cfgfile{"res/map.yaml"};
+  std::string map_binfile{"res/map_test.bin"};
+  ASSERT_NO_THROW(convertMapConfigToBinary(map_cfgfile, map_binfile));
+
+  LandmarkMap map_yaml(map_cfgfile);
+  LandmarkMap map_bin(map_binfile);
+  ASSERT_EQ(map_yaml.getIds(), map_bin.getIds());
+  ASSERT_DOUBLE_EQ(map_yaml.getMinHeight(), map_bin.getMinHeight());
+  for (auto& el : map_yaml.getWorldLandmarks()) {
+    auto& points = map_bin.getWorldLandmarks().at(el.first).points;
+    ASSERT_EQ(el.second.points.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+      ASSERT_DOUBLE_EQ(el.second.points[i][(int)POINT::Z], points[i][(int)POINT::Z]);
+    }
+  }
+  ASSERT_TRUE(map_bin.contains(0x0016));
+  ASSERT_FALSE(map_bin.contains(0x0001));
+}
+
+TEST(LandmarkMap, Family) {
+  landmark_map_t landmarks;
+  landmarks[0x80000001] = Landmark(0x80000001, LANDMARK_FAMILY::GRID_6x6);
+  landmarks[0x00000007] = Landmark(0x00000007, LANDMARK_FAMILY::GRID_6x6);
+  LandmarkMap map(landmarks, LANDMARK_FAMILY::GRID_6x6);
+  ASSERT_EQ(LANDMARK_FAMILY::GRID_6x6, map.getFamily());
+  ASSERT_EQ(3 + 3, map.getMaxPointCount());
+
+  // The family is stored in binary maps, the default of the loader does not apply
+  std::string map_binfile{"res/map_test.bin"};
+  ASSERT_NO_THROW(writeBinaryMap(map_binfile, landmarks, LANDMARK_FAMILY::GRID_6x6));
+  ASSERT_EQ(LANDMARK_FAMILY::GRID_6x6, BinaryMap(map_binfile).getFamily());
+  LandmarkMap map_bin(map_binfile);
+  ASSERT_EQ(LANDMARK_FAMILY::GRID_6x6, map_bin.getFamily());
+  for (auto& el : landmarks) {
+    auto& points = map_bin.getLandmarks().at(el.first).points;
+    ASSERT_TRUE(std::equal(
+        points.begin(), points.end(), el.second.points.begin(), el.second.points.end()));
+  }
+
+  // Applying a delta keeps the family
+  LandmarkMapDelta delta;
+  delta.changed[0x0000FFFF] = Landmark(0x0000FFFF, LANDMARK_FAMILY::GRID_6x6);
+  LandmarkMap::ConstPtr updated = map.Apply(delta);
+  ASSERT_EQ(LANDMARK_FAMILY::GRID_6x6, updated->getFamily());
+  ASSERT_EQ(3 + 16, updated->getMaxPointCount());
+  ASSERT_EQ(LANDMARK_FAMILY::GRID_4x4, LandmarkMap("res/map.yaml").getFamily());
+}
+
+TEST(LandmarkMap, Publish) {
+  landmark_map_t landmarks;
+  ASSERT_NO_THROW(readMapConfig("res/map.yaml", landmarks));
+  auto handle = std::make_shared<LandmarkMapHandle>(std::make_shared<const LandmarkMap>(landmarks));
+
+  LandmarkMap::ConstPtr snapshot;
+  uint64_t generation = 0;
+  ASSERT_TRUE(handle->Update(snapshot, generation));
+  ASSERT_FALSE(handle->Update(snapshot, generation));
+  ASSERT_TRUE(snapshot->contains(0x0016));
+
+  // A snapshot stays valid after a new map has been published
+  LandmarkMap::ConstPtr old_snapshot = snapshot;
+  landmarks.erase(0x0016);
+  handle->Publish(std::make_shared<const LandmarkMap>(landmarks));
+  ASSERT_TRUE(handle->Update(snapshot, generation));
+  ASSERT_FALSE(snapshot->contains(0x0016));
+  ASSERT_TRUE(old_snapshot->contains(0x0016));
+  ASSERT_EQ(handle->getGeneration(), generation);
+}
+
+TEST(LandmarkMap, VisibleLandmarks) {
+  camera_params_t camera_intrinsics;
+  ASSERT_NO_THROW(readCamConfig("res/cam.yaml", camera_intrinsics));
+  LandmarkMap map("res/map.yaml");
+  const int width = 2 * camera_intrinsics[(int)INTRINSICS::u0];
+  const int height = 2 * camera_intrinsics[(int)INTRINSICS::v0];
+
+  // Reference: Project all landmarks
+  auto get_expected_ids = [&](const pose_t& camera_pose) {
+    std::vector<landmark_id_t> expected_ids;
+    const double rotation[3] = {-camera_pose[(int)POSE::Rx],
+                                -camera_pose[(int)POSE::Ry],
+                                -camera_pose[(int)POSE::Rz]};
+    for (auto& el : map.getWorldLandmarks()) {
+      for (auto& pt : el.second.points) {
+        const double p_world[3] = {pt[(int)POINT::X] - camera_pose[(int)POSE::X],
+                                   pt[(int)POINT::Y] - camera_pose[(int)POSE::Y],
+                                   pt[(int)POINT::Z] - camera_pose[(int)POSE::Z]};
+        double p_camera[3];
+        ceres::AngleAxisRotatePoint(rotation, p_world, p_camera);
+        double u, v;
+        transformWorldToImg(pt[(int)POINT::X],
+                            pt[(int)POINT::Y],
+                            pt[(int)POINT::Z],
+                            camera_pose.data(),
+                            camera_intrinsics.data(),
+                            &u,
+                            &v);
+        if (p_camera[2] > 0 && u >= 0 && u < width && v >= 0 && v < height) {
+          expected_ids.push_back(el.first);
+          break;
+        }
+      }
+    }
+    return expected_ids;
+  };
+
+  // Camera below landmark 0x0016, looking upwards
+  pose_t camera_pose = {{0., 0., 0., 0., 0., 0.}};
+  camera_pose[(int)POSE::X] = map.getLandmarks().at(0x0016).pose[(int)POSE::X];
+  camera_pose[(int)POSE::Y] = map.getLandmarks().at(0x0016).pose[(int)POSE::Y];
+  std::vector<landmark_id_t> ids;
+  map.getVisibleLandmarks(camera_pose, camera_intrinsics, width, height, ids);
+  ASSERT_EQ(get_expected_ids(camera_pose), ids);
+  ASSERT_NE(ids.end(), std::find(ids.begin(), ids.end(), 0x0016));
+  ASSERT_EQ(ids.end(), std::find(ids.begin(), ids.end(), 0x0980));
+
+  // Tilted camera
+  camera_pose[(int)POSE::Rx] = 0.3;
+  camera_pose[(int)POSE::Ry] = -0.2;
+  map.getVisibleLandmarks(camera_pose, camera_intrinsics, width, height, ids);
+  ASSERT_EQ(get_expected_ids(camera_pose), ids);
+
+  // Camera looking sideways, the frustum is unbounded
+  camera_pose[(int)POSE::Rx] = 0.;
+  camera_pose[(int)POSE::Ry] = M_PI / 2;
+  map.getVisibleLandmarks(camera_pose, camera_intrinsics, width, height, ids);
+  ASSERT_EQ(get_expected_ids(camera_pose), ids);
+
+  // Camera looking downwards
+  camera_pose[(int)POSE::Ry] = M_PI;
+  map.getVisibleLandmarks(camera_pose, camera_intrinsics, width, height, ids);
+  ASSERT_TRUE(ids.empty());
+}
+
+TEST(LandmarkMap, VisibilityTable) {
+  camera_params_t camera_intrinsics;
+  ASSERT_NO_THROW(readCamConfig("res/cam.yaml", camera_intrinsics));
+  LandmarkMap map("res/map.yaml");
+  const int width = 2 * camera_intrinsics[(int)INTRINSICS::u0];
+  const int height = 2 * camera_intrinsics[(int)INTRINSICS::v0];
+  VisibilityTable table(map, camera_intrinsics, width, height, 0., 0.5, 0.1);
+
+  std::string table_file{"res/visibility_test.bin"};
+  ASSERT_NO_THROW(writeVisibilityTable(table_file, table));
+  VisibilityTable table_read(table_file);
+  ASSERT_EQ(map.getFingerprint(), table.getMapFingerprint());
+  ASSERT_EQ(map.getFingerprint(), table_read.getMapFingerprint());
+
+  // Any change of the map changes the fingerprint, equal content keeps it
+  ASSERT_EQ(map.getFingerprint(), LandmarkMap(map.getLandmarks()).getFingerprint());
+  LandmarkMapDelta delta;
+  delta.changed[0x0016] = map.getLandmarks().at(0x0016);
+  ASSERT_EQ(map.getFingerprint(), map.Apply(delta)->getFingerprint());
+  delta.changed[0x0016].pose[(int)POSE::X] += 0.01;
+  ASSERT_NE(map.getFingerprint(), map.Apply(delta)->getFingerprint());
+
+  // Every landmark in view of a camera with arbitrary yaw and small tilt has to be in the set
+  std::vector<landmark_id_t> ids;
+  for (double x = 0.; x < 18.; x += 0.7) {
+    for (double y = -1.; y < 7.; y += 0.7) {
+      auto visible_ids = table.getVisibleIds(x, y);
+      auto visible_ids_read = table_read.getVisibleIds(x, y);
+      ASSERT_TRUE(std::equal(visible_ids.begin(),
+                             visible_ids.end(),
+                             visible_ids_read.begin(),
+                             visible_ids_read.end()));
+      for (double yaw = 0.; yaw < 2 * M_PI; yaw += 0.5) {
+        pose_t camera_pose = {{x, y, 0., 0.05, -0.05, yaw}};
+        map.getVisibleLandmarks(camera_pose, camera_intrinsics, width, height, ids);
+        ASSERT_TRUE(std::includes(visible_ids.begin(), visible_ids.end(), ids.begin(), ids.end()));
+      }
+    }
+  }
+
+  // Far landmarks are not part of the set
+  auto visible_ids = table.getVisibleIds(map.getLandmarks().at(0x0016).pose[(int)POSE::X],
+                                         map.getLandmarks().at(0x0016).pose[(int)POSE::Y]);
+  ASSERT_NE(visible_ids.end(), std::find(visible_ids.begin(), visible_ids.end(), 0x0016));
+  ASSERT_EQ(visible_ids.end(), std::find(visible_ids.begin(), visible_ids.end(), 0x0980));
+  ASSERT_TRUE(table.getVisibleIds(-100., -100.).empty());
+  ASSERT_FALSE(table.contains(-100., -100.));
+  ASSERT_TRUE(table.contains(map.getLandmarks().at(0x0016).pose[(int)POSE::X],
+                             map.getLandmarks().at(0x0016).pose[(int)POSE::Y]));
+
+  // Corrupt cell offsets, that start right after the 56 byte header
+  std::string data;
+  {
+    std::ifstream fin(table_file, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+  }
+  uint32_t* offsets = reinterpret_cast<uint32_t*>(&data[56]);
+  ASSERT_EQ(0, offsets[0]);
+  size_t cell = 1;
+  while (offsets[cell] == 0) {
+    cell++;
+  }
+  std::string corrupted = data;
+  reinterpret_cast<uint32_t*>(&corrupted[56])[cell - 1] = offsets[cell] + 1;  // Decreasing
+  std::ofstream(table_file, std::ios::binary) << corrupted;
+  ASSERT_THROW(VisibilityTable{table_file}, std::runtime_error);
+  corrupted = data;
+  reinterpret_cast<uint32_t*>(&corrupted[56])[cell] = std::numeric_limits<uint32_t>::max();
+  std::ofstream(table_file, std::ios::binary) << corrupted;
+  ASSERT_THROW(VisibilityTable{table_file}, std::runtime_error);
+
+  // Cell count beyond the file size (cols at byte 12)
+  corrupted = data;
+  reinterpret_cast<int32_t*>(&corrupted[12])[0] = std::numeric_limits<int32_t>::max();
+  std::ofstream(table_file, std::ios::binary) << corrupted;
+  ASSERT_THROW(VisibilityTable{table_file}, std::runtime_error);
+  std::ofstream(table_file, std::ios::binary) << data.substr(0, data.size() - 1);
+  ASSERT_THROW(VisibilityTable{table_file}, std::runtime_error);
+}
+
+TEST(LandmarkMap, ApplyDelta) {
+  landmark_map_t landmarks;
+  ASSERT_NO_THROW(readMapConfig("res/map.yaml", landmarks));
+  auto map = std::make_shared<const LandmarkMap>(landmarks);
+
+  // Move, remove and add a landmark
+  landmark_map_t modified = landmarks;
+  modified.at(0x0016).pose[(int)POSE::X] += 0.5;
+  modified.at(0x0016).pose[(int)POSE::Z] += 1.;
+  modified.erase(0x0086);
+  modified[0x0001] = Landmark(0x0001);
+  modified[0x0001].pose = landmarks.at(0x0112).pose;
+  modified[0x0001].pose[(int)POSE::Y] += 0.2;
+
+  const LandmarkMapDelta delta = computeMapDelta(landmarks, modified);
+  ASSERT_EQ(2, delta.changed.size());
+  ASSERT_EQ(std::vector<landmark_id_t>{0x0086}, delta.removed);
+
+  // Delta file round trip
+  ASSERT_NO_THROW(writeMapDelta("res/map_delta_test.yaml", delta));
+  LandmarkMapDelta delta_test;
+  ASSERT_NO_THROW(readMapDelta("res/map_delta_test.yaml", delta_test));
+  ASSERT_EQ(delta.removed, delta_test.removed);
+  ASSERT_EQ(delta.changed.size(), delta_test.changed.size());
+  landmark_map_t applied = landmarks;
+  applyMapDelta(applied, delta);
+  ASSERT_EQ(modified.size(), applied.size());
+
+  // The updated map equals a freshly built one
+  LandmarkMap::ConstPtr updated = map->Apply(delta);
+  LandmarkMap expected(modified);
+  ASSERT_EQ(expected.getIds(), updated->getIds());
+  ASSERT_DOUBLE_EQ(expected.getMinHeight(), updated->getMinHeight());
+  ASSERT_DOUBLE_EQ(expected.getMaxHeight(), updated->getMaxHeight());
+  for (auto& el : expected.getWorldLandmarks()) {
+    auto& points = updated->getWorldLandmarks().at(el.first).points;
+    ASSERT_EQ(el.second.points.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+      ASSERT_EQ(el.second.points[i], points[i]);
+    }
+  }
+  std::vector<landmark_id_t> ids, expected_ids;
+  for (double x = -2.; x < 12.; x += 0.7) {
+    for (double y = -2.; y < 8.; y += 0.7) {
+      expected.getGrid().QueryBox(x, y, x + 1., y + 1.5, expected_ids);
+      updated->getGrid().QueryBox(x, y, x + 1., y + 1.5, ids);
+      ASSERT_EQ(expected_ids, ids);
+    }
+  }
+
+  // The original map is untouched
+  ASSERT_TRUE(map->contains(0x0086));
+  ASSERT_FALSE(map->contains(0x0001));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "PosePublisher.h"
+#include "gtest/gtest.h"
+
+using namespace stargazer;
+
+namespace {
+
+/// Pose, whose entries all hold the same value, so torn reads are easy to detect
+PoseSnapshot makeSnapshot(uint64_t value) {
+  PoseSnapshot snapshot;
+  snapshot.pose.fill(static_cast<double>(value));
+  snapshot.covariance.fill(static_cast<double>(value));
+  snapshot.timestamp = value;
+  snapshot.has_covariance = true;
+  return snapshot;
+}
+
+bool isConsistent(const PoseSnapshot& snapshot) {
+  for (double value : snapshot.pose) {
+    if (value != static_cast<double>(snapshot.timestamp)) return false;
+  }
+  for (double value : snapshot.covariance) {
+    if (value != static_cast<double>(snapshot.timestamp)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(PosePublisher, Local) {
+  PosePublisher publisher;
+  ASSERT_EQ(0u, publisher.getVersion());
+  PoseSnapshot snapshot;
+  ASSERT_TRUE(publisher.TryRead(snapshot));
+  ASSERT_FALSE(snapshot.has_covariance);
+
+  publisher.Publish(makeSnapshot(7));
+  ASSERT_EQ(1u, publisher.getVersion());
+  snapshot = publisher.Read();
+  ASSERT_EQ(7u, snapshot.timestamp);
+  ASSERT_TRUE(isConsistent(snapshot));
+}
+
+TEST(PosePublisher, ConcurrentReaders) {
+  constexpr uint64_t kWrites = 200000;
+  PosePublisher publisher;
+  std::atomic<bool> done{false};
+  std::atomic<bool> torn{false};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; r++) {
+    readers.emplace_back([&]() {
+      uint64_t last = 0;
+      while (!done.load()) {
+        const PoseSnapshot snapshot = publisher.Read();
+        if (!isConsistent(snapshot) || snapshot.timestamp < last) {
+          torn = true;
+        }
+        last = snapshot.timestamp;
+      }
+    });
+  }
+  for (uint64_t i = 1; i <= kWrites; i++) {
+    publisher.Publish(makeSnapshot(i));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_FALSE(torn.load());
+  ASSERT_EQ(kWrites, publisher.Read().timestamp);
+}
+
+TEST(PosePublisher, SharedMemory) {
+  const std::string name = "/stargazer_test_pose_" + std::to_string(::getpid());
+  ASSERT_THROW(PoseReader{name}, std::runtime_error);
+  {
+    PosePublisher publisher(name);
+    PoseReader reader(name);
+    ASSERT_EQ(0u, reader.getVersion());
+    // A second publisher must not take over the segment
+    ASSERT_THROW(PosePublisher{name}, std::runtime_error);
+
+    publisher.Publish(makeSnapshot(3));
+    ASSERT_EQ(1u, reader.getVersion());
+    PoseSnapshot snapshot;
+    ASSERT_TRUE(reader.TryRead(snapshot));
+    ASSERT_EQ(3u, snapshot.timestamp);
+    ASSERT_TRUE(isConsistent(snapshot));
+  }
+  // The publisher removes the segment
+  ASSERT_THROW(PoseReader{name}, std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
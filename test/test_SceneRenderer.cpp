@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "LandmarkFinder.h"
+#include "SceneRenderer.h"
+#include "StargazerConfig.h"
+#include "gtest/gtest.h"
+
+using namespace stargazer;
+
+namespace {
+
+/// Camera looking upwards, right below landmark 0x0190 of the test map
+const pose_t kCameraPose = {{2.68, 0.69, 0., 0., 0., 0.}};
+
+SceneRenderer::Options testOptions() {
+  SceneRenderer::Options options;
+  options.imageWidth = 736;
+  options.imageHeight = 468;
+  return options;
+}
+
+camera_params_t testIntrinsics() {
+  camera_params_t camera_intrinsics;
+  readCamConfig("res/cam.yaml", camera_intrinsics);
+  return camera_intrinsics;
+}
+
+const ImgLandmark* findLandmark(const std::vector<ImgLandmark>& landmarks, landmark_id_t id) {
+  auto it = std::find_if(landmarks.begin(), landmarks.end(), [id](const ImgLandmark& lm) { return lm.nID == id; });
+  return it == landmarks.end() ? nullptr : &*it;
+}
+
+}  // namespace
+
+TEST(SceneRenderer, GroundTruth) {
+  auto map = std::make_shared<const LandmarkMap>("res/map.yaml");
+  SceneRenderer renderer(map, testIntrinsics(), testOptions());
+  SceneFrame frame = renderer.Render(kCameraPose);
+
+  ASSERT_EQ(468, frame.image.rows);
+  ASSERT_EQ(736, frame.image.cols);
+  ASSERT_EQ(kCameraPose, frame.pose);
+  const ImgLandmark* lm = findLandmark(frame.landmarks, 0x0190);
+  ASSERT_NE(nullptr, lm);
+  ASSERT_EQ(map->getLandmarks().at(0x0190).points.size(), 3 + lm->idPoints.size());
+  for (const ImgPoint& corner : lm->corners) {
+    ASSERT_EQ(255, frame.image.at<uint8_t>(corner.y, corner.x));  // Saturated LED
+  }
+}
+
+TEST(SceneRenderer, Dropout) {
+  auto map = std::make_shared<const LandmarkMap>("res/map.yaml");
+  SceneRenderer::Options options = testOptions();
+  options.dropoutProbability = 1.;
+  SceneRenderer renderer(map, testIntrinsics(), options);
+  ASSERT_TRUE(renderer.Render(kCameraPose).landmarks.empty());
+}
+
+TEST(SceneRenderer, Repeatable) {
+  auto map = std::make_shared<const LandmarkMap>("res/map.yaml");
+  SceneRenderer::Options options = testOptions();
+  options.noiseSigma = 5.;
+  options.blurSigma = 0.7;
+  options.reflectionCount = 20;
+  options.dropoutProbability = 0.1;
+  options.seed = 7;
+  const std::vector<pose_t> trajectory = {kCameraPose, {{3., 1., 0., 0., 0., 0.5}}};
+  std::vector<SceneFrame> first = SceneRenderer(map, testIntrinsics(), options).Render(trajectory);
+  std::vector<SceneFrame> second = SceneRenderer(map, testIntrinsics(), options).Render(trajectory);
+
+  ASSERT_EQ(2u, first.size());
+  for (size_t i = 0; i < first.size(); i++) {
+    ASSERT_EQ(0., cv::norm(first[i].image, second[i].image, cv::NORM_L1));
+    ASSERT_EQ(first[i].landmarks.size(), second[i].landmarks.size());
+  }
+}
+
+TEST(SceneRenderer, Detection) {
+  auto map = std::make_shared<const LandmarkMap>("res/map.yaml");
+  SceneRenderer renderer(map, testIntrinsics(), testOptions());
+  SceneFrame frame = renderer.Render(kCameraPose);
+
+  LandmarkFinder finder(map);
+  std::vector<ImgLandmark> detected;
+  finder.DetectLandmarks(frame.image, detected);
+  for (const ImgLandmark& truth : frame.landmarks) {
+    const ImgLandmark* lm = findLandmark(detected, truth.nID);
+    ASSERT_NE(nullptr, lm) << "Missed landmark " << truth.nID;
+    ASSERT_EQ(truth.idPoints.size(), lm->idPoints.size());
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
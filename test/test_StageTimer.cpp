@@ -0,0 +1,47 @@
+#include <chrono>
+#include <thread>
+
+#include "StargazerStats.h"
+#include "gtest/gtest.h"
+#include "internal/StageTimer.h"
+
+using namespace stargazer;
+
+TEST(StageTimer, Disabled) {
+  DetectionStats* stats = nullptr;
+  StageTimer timer(stats, &DetectionStats::blobTime, "FindBlobs");
+  timer.Stop();  // Must not touch the stats
+}
+
+TEST(StageTimer, Accumulates) {
+  DetectionStats stats;
+  {
+    StageTimer timer(&stats, &DetectionStats::blobTime, "FindBlobs");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const double first = stats.blobTime;
+  ASSERT_GE(first, 0.002);
+  ASSERT_EQ(0., stats.clusterTime);
+
+  StageTimer timer(&stats, &DetectionStats::blobTime, "FindBlobs");
+  timer.Stop();
+  const double second = stats.blobTime;
+  ASSERT_GE(second, first);
+  timer.Stop();  // Only the first call counts
+  ASSERT_EQ(second, stats.blobTime);
+  ASSERT_EQ(stats.blobTime, stats.getTotalTime());
+}
+
+TEST(StageTimer, LocalizationStats) {
+  LocalizationStats stats;
+  {
+    StageTimer timer(&stats, &LocalizationStats::solveTime, "Optimize");
+  }
+  ASSERT_GE(stats.solveTime, 0.);
+  ASSERT_EQ(stats.solveTime, stats.getTotalTime());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
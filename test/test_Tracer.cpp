@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Tracer.h"
+#include "gtest/gtest.h"
+
+using namespace stargazer;
+
+namespace {
+
+std::string readTrace() {
+  const std::string tracefile = "tracer_test.json";
+  Tracer::Write(tracefile);
+  std::ifstream fin(tracefile);
+  std::stringstream content;
+  content << fin.rdbuf();
+  std::remove(tracefile.c_str());
+  return content.str();
+}
+
+}  // namespace
+
+TEST(Tracer, Disabled) {
+  Tracer::Disable();
+  Tracer::Begin("Disabled stage");
+  {
+    TraceScope scope("Disabled scope");
+  }
+  const std::string trace = readTrace();
+  ASSERT_EQ(std::string::npos, trace.find("Disabled stage"));
+  ASSERT_EQ(std::string::npos, trace.find("Disabled scope"));
+  ASSERT_EQ(0u, trace.find("{\"displayTimeUnit\""));
+}
+
+TEST(Tracer, Threads) {
+  Tracer::Enable();
+  {
+    TraceScope scope("Main stage");
+    Tracer::AsyncBegin("Queue", 7);
+  }
+  std::thread worker([]() {
+    Tracer::SetThreadName("Worker \"1\"\n");
+    Tracer::AsyncEnd("Queue", 7);
+    TraceScope scope("Worker stage");
+  });
+  worker.join();
+  Tracer::Disable();
+
+  // Events of ended threads are kept
+  const std::string trace = readTrace();
+  ASSERT_NE(std::string::npos, trace.find("\"name\": \"Main stage\", \"cat\": \"stargazer\", \"ph\": \"B\""));
+  ASSERT_NE(std::string::npos, trace.find("\"name\": \"Main stage\", \"cat\": \"stargazer\", \"ph\": \"E\""));
+  ASSERT_NE(std::string::npos, trace.find("\"name\": \"Worker stage\""));
+  ASSERT_NE(std::string::npos, trace.find("\"ph\": \"b\""));
+  ASSERT_NE(std::string::npos, trace.find("\"ph\": \"e\""));
+  ASSERT_NE(std::string::npos, trace.find("\"id\": \"0x7\""));
+  ASSERT_NE(std::string::npos, trace.find("\"args\": {\"name\": \"Worker \\\"1\\\"\\u000a\"}"));
+}
+
+TEST(Tracer, EndedThreads) {
+  Tracer::Enable();
+  // Frame ids exceed 32 bits in long runs
+  const uint64_t frame_id = 0x123456789abcull;
+  for (int i = 0; i < 4; i++) {
+    std::thread worker([frame_id]() {
+      Tracer::AsyncBegin("Long queue", frame_id);
+      TraceScope scope("Ended thread");
+    });
+    worker.join();
+  }
+  Tracer::Disable();
+
+  const std::string trace = readTrace();
+  ASSERT_NE(std::string::npos, trace.find("\"id\": \"0x123456789abc\""));
+  size_t count = 0;
+  for (size_t pos = trace.find("Ended thread"); pos != std::string::npos;
+       pos = trace.find("Ended thread", pos + 1)) {
+    count++;
+  }
+  ASSERT_EQ(8u, count);
+}
+
+TEST(Tracer, FullBuffer) {
+  Tracer::Enable(2);
+  const uint64_t dropped = Tracer::getDroppedCount();
+  std::thread worker([]() {
+    Tracer::Begin("First");
+    Tracer::End("First");
+    Tracer::Begin("Dropped");
+  });
+  worker.join();
+  Tracer::Disable();
+  ASSERT_EQ(dropped + 1, Tracer::getDroppedCount());
+  ASSERT_EQ(std::string::npos, readTrace().find("Dropped"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
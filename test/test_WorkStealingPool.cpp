@@ -0,0 +1,77 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "internal/WorkStealingPool.h"
+
+using namespace stargazer;
+
+TEST(WorkStealingPool, RunsAllTasks) {
+  constexpr int kTasks = 10000;
+  std::atomic<int> count{0};
+  {
+    WorkStealingPool pool(4);
+    ASSERT_EQ(4, pool.getThreadCount());
+    for (int i = 0; i < kTasks; i++) {
+      pool.Submit([&count]() { count++; });
+    }
+    while (count < kTasks) {
+      std::this_thread::yield();
+    }
+  }
+  ASSERT_EQ(kTasks, count);
+}
+
+TEST(WorkStealingPool, NestedSubmit) {
+  // Every task spawns its successor on the same worker, the others have to steal the rest
+  constexpr int kChains = 8;
+  constexpr int kLength = 1000;
+  std::atomic<int> count{0};
+  WorkStealingPool pool(4);
+  std::function<void(int)> step = [&](int remaining) {
+    count++;
+    if (remaining > 1) {
+      pool.Submit([&step, remaining]() { step(remaining - 1); });
+    }
+  };
+  for (int i = 0; i < kChains; i++) {
+    pool.Submit([&step]() { step(kLength); });
+  }
+  while (count < kChains * kLength) {
+    std::this_thread::yield();
+  }
+  pool.Stop();
+  ASSERT_EQ(kChains * kLength, count);
+}
+
+TEST(WorkStealingPool, StopDiscardsBacklog) {
+  constexpr int kTasks = 100;
+  std::atomic<bool> release{false};
+  std::atomic<int> count{0};
+  WorkStealingPool pool(1);
+  pool.Submit([&release]() {
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  for (int i = 0; i < kTasks; i++) {
+    pool.Submit([&count]() { count++; });
+  }
+
+  // Stop waits for the blocked task, the backlog must not run afterwards
+  std::thread stopper([&pool]() { pool.Stop(); });
+  while (pool.TrySubmit([&count]() { count++; })) {
+    std::this_thread::yield();
+  }
+  release = true;
+  stopper.join();
+  ASSERT_EQ(0, count);
+  ASSERT_FALSE(pool.isRunning());
+  ASSERT_THROW(pool.Submit([&count]() { count++; }), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -78,6 +78,61 @@ TEST(Landmark, TestID4184) {
   ASSERT_EQ(3 * Landmark::kGridDistance, a.points[6][(int)POINT::Y]);
 }
 
+TEST(Landmark, ConstexprPoints) {
+  // Pattern is expanded at compile time
+  constexpr landmark_points_t points = getLandmarkPoints(16772);
+  static_assert(points.size() == 7, "Wrong number of points for ID 4184");
+  static_assert(points[3][(int)POINT::X] == 2 * kLandmarkGridDistance, "Wrong id point");
+
+  Landmark a = Landmark(16772);
+  ASSERT_EQ(points.size(), a.points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    ASSERT_EQ(points[i], a.points[i]);
+  }
+}
+
+template <typename Family>
+void checkFamily() {
+  // Every inner point has its own bit, and all of them fit into the ID type
+  landmark_id_t all_bits = 0;
+  for (int y = 0; y < Family::kGridCount; y++) {
+    for (int x = 0; x < Family::kGridCount; x++) {
+      if (Family::isCorner(x, y)) {
+        continue;
+      }
+      const landmark_id_t bit = Family::getBit(x, y);
+      ASSERT_NE(0u, bit);
+      ASSERT_EQ(0u, all_bits & bit);
+      all_bits |= bit;
+    }
+  }
+  // A landmark with all inner points lit
+  const landmark_points_t points = Family::getPoints(all_bits);
+  ASSERT_EQ(static_cast<size_t>(Family::kMaxPoints), points.size());
+  const double lc = (Family::kGridCount - 1) * kLandmarkGridDistance;
+  ASSERT_EQ(lc, points[2][(int)POINT::X]);
+  ASSERT_EQ(lc, points[2][(int)POINT::Y]);
+}
+
+TEST(Landmark, Families) {
+  checkFamily<LandmarkFamily4x4>();
+  checkFamily<LandmarkFamily5x5>();
+  checkFamily<LandmarkFamily6x6>();
+
+  // The 4x4 layout is the Hagisonic one
+  static_assert(LandmarkFamily4x4::getBit(2, 0) == 0x0004, "Wrong bit");
+  static_assert(LandmarkFamily4x4::getBit(2, 3) == 0x4000, "Wrong bit");
+  // The 6x6 layout skips the corners to fit into 32 bits
+  static_assert(LandmarkFamily6x6::getBit(1, 0) == 0x1, "Wrong bit");
+  static_assert(LandmarkFamily6x6::getBit(4, 5) == 0x80000000, "Wrong bit");
+
+  Landmark a(0x80000001, LANDMARK_FAMILY::GRID_6x6);
+  ASSERT_EQ(5u, a.points.size());
+  ASSERT_EQ(1 * Landmark::kGridDistance, a.points[3][(int)POINT::X]);
+  ASSERT_EQ(4 * Landmark::kGridDistance, a.points[4][(int)POINT::X]);
+  ASSERT_EQ(5 * Landmark::kGridDistance, a.points[4][(int)POINT::Y]);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,427 @@
+//
+// This file is part of the stargazer library.
+//
+// Copyright 2016 Claudio Bandera <claudio.bandera@kit.edu (Karlsruhe Institute of Technology)
+//
+// The stargazer library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The stargazer library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+// Offline replay of recorded frames through LandmarkFinder and Localizer, without any GUI.
+//
+//   stargazer_replay <image directory|video file> <cam.yaml> <map.yaml> [options]
+//
+// Images of a directory are replayed in filename order. Frames are decoded by prefetch threads and
+// detected by --parallel threads, localization runs in frame order on the main thread. The
+// trajectory is written in the format of writeSceneFrames' ground truth, so synthetic datasets
+// can be compared directly. Every frame is marked with Valid, frames without pose have no pose
+// fields. Throughput, per-frame latency and detection rates go to stdout.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "CeresLocalizer.h"
+#include "LandmarkFinder.h"
+#include "Tracer.h"
+#include "internal/BoundedQueue.h"
+#include "internal/ConfigWriter.h"
+
+using namespace stargazer;
+
+namespace {
+
+typedef std::chrono::steady_clock clock;
+
+struct ReplayOptions {
+  std::string input;
+  std::string cam_cfgfile;
+  std::string map_cfgfile;
+  std::string output = "trajectory.yaml";
+  std::string localizer = "ceres";
+  std::string tracefile;
+  size_t prefetch_threads = 2;
+  size_t parallel_frames = 1;
+  size_t max_frames = 0;
+  double fps = 30.;
+};
+
+/// Decoded frame, waiting for detection
+struct LoadedFrame {
+  size_t index = 0;
+  cv::Mat img;
+  clock::time_point loaded;
+};
+
+/// Detected frame, waiting for localization in frame order
+struct DetectedFrame {
+  std::vector<ImgLandmark> landmarks;
+  LandmarkMap::ConstPtr map;
+  clock::time_point loaded;
+  double detection_time = 0.;
+};
+
+void printUsage() {
+  std::cerr << "Usage: stargazer_replay <image directory|video file> <cam.yaml> <map.yaml> [options]\n"
+               "  --output <file>      Trajectory file (trajectory.yaml)\n"
+               "  --localizer <name>   ceres, ceres2d or none (ceres)\n"
+               "  --prefetch <n>       Image decoding threads (2)\n"
+               "  --parallel <n>       Frames detected in parallel (1)\n"
+               "  --max-frames <n>     Stop after n frames (all)\n"
+               "  --fps <rate>         Frame rate, sets dt of the localizer (30)\n"
+               "  --trace <file>       Write a Chrome trace of all stages\n";
+}
+
+ReplayOptions parseOptions(int argc, char** argv) {
+  if (argc < 4) {
+    throw std::invalid_argument("Missing arguments");
+  }
+  ReplayOptions options;
+  options.input = argv[1];
+  options.cam_cfgfile = argv[2];
+  options.map_cfgfile = argv[3];
+  for (int i = 4; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value of " + arg);
+    }
+    const std::string value = argv[++i];
+    if (arg == "--output") {
+      options.output = value;
+    } else if (arg == "--localizer") {
+      options.localizer = value;
+    } else if (arg == "--prefetch") {
+      options.prefetch_threads = std::max<size_t>(1, std::stoul(value));
+    } else if (arg == "--parallel") {
+      options.parallel_frames = std::max<size_t>(1, std::stoul(value));
+    } else if (arg == "--max-frames") {
+      options.max_frames = std::stoul(value);
+    } else if (arg == "--fps") {
+      options.fps = std::stod(value);
+    } else if (arg == "--trace") {
+      options.tracefile = value;
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+  if (options.localizer != "ceres" && options.localizer != "ceres2d" && options.localizer != "none") {
+    throw std::invalid_argument("Unknown localizer " + options.localizer);
+  }
+  return options;
+}
+
+/**
+ * @brief Frames of an image directory or a video file, decoded by prefetch threads
+ */
+class FrameSource {
+ public:
+  FrameSource(const ReplayOptions& options, BoundedQueue<LoadedFrame>& queue) : queue_(queue) {
+    if (std::filesystem::is_directory(options.input)) {
+      for (const auto& entry : std::filesystem::directory_iterator(options.input)) {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" ||
+            extension == ".pgm" || extension == ".tif" || extension == ".tiff") {
+          names_.push_back(entry.path().filename().string());
+        }
+      }
+      std::sort(names_.begin(), names_.end());
+      if (options.max_frames > 0 && names_.size() > options.max_frames) {
+        names_.resize(options.max_frames);
+      }
+      directory_ = options.input;
+      for (size_t t = 0; t < options.prefetch_threads; t++) {
+        threads_.emplace_back(&FrameSource::ReadImages, this);
+      }
+    } else {
+      video_.open(options.input);
+      if (!video_.isOpened()) {
+        throw std::runtime_error("Could not open input: " + options.input);
+      }
+      max_frames_ = options.max_frames;
+      threads_.emplace_back(&FrameSource::ReadVideo, this);  // Videos can only be decoded in order
+    }
+  }
+
+  ~FrameSource() {
+    is_running_ = false;
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /**
+   * @brief Whether all frames have been decoded
+   */
+  bool isFinished() const { return finished_threads_.load() == threads_.size(); }
+
+  /**
+   * @brief Name of a frame in the trajectory
+   */
+  std::string getName(size_t index) const {
+    if (index < names_.size()) {
+      return names_[index];
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05zu", index);
+    return name;
+  }
+
+ private:
+  void ReadImages() {
+    Tracer::SetThreadName("Prefetch");
+    for (size_t i = next_index_++; i < names_.size() && is_running_; i = next_index_++) {
+      LoadedFrame frame;
+      frame.index = i;
+      {
+        TraceScope trace("Decode");
+        frame.img = cv::imread(directory_ + "/" + names_[i], cv::IMREAD_GRAYSCALE);
+      }
+      if (frame.img.empty()) {
+        std::cerr << "Could not read image: " << names_[i] << std::endl;
+      }
+      Push(frame);
+    }
+    finished_threads_++;
+  }
+
+  void ReadVideo() {
+    Tracer::SetThreadName("Prefetch");
+    for (size_t i = 0; (max_frames_ == 0 || i < max_frames_) && is_running_; i++) {
+      LoadedFrame frame;
+      frame.index = i;
+      {
+        TraceScope trace("Decode");
+        if (!video_.read(frame.img)) {
+          break;
+        }
+        if (frame.img.channels() == 3) {
+          cv::cvtColor(frame.img, frame.img, cv::COLOR_BGR2GRAY);
+        }
+      }
+      Push(frame);
+    }
+    finished_threads_++;
+  }
+
+  void Push(LoadedFrame& frame) {
+    frame.loaded = clock::now();
+    Backoff backoff;
+    while (!queue_.TryPush(frame) && is_running_) {
+      backoff.Wait();
+    }
+  }
+
+  BoundedQueue<LoadedFrame>& queue_;      /**< Decoded frames */
+  std::string directory_;                 /**< Image directory */
+  std::vector<std::string> names_;        /**< Sorted image names */
+  cv::VideoCapture video_;                /**< Video file */
+  size_t max_frames_ = 0;                 /**< Frame limit of the video, 0 for all */
+  std::atomic<size_t> next_index_{0};     /**< Next image to decode */
+  std::atomic<bool> is_running_{true};    /**< Cleared to cancel decoding */
+  std::atomic<size_t> finished_threads_{0}; /**< Threads done with decoding */
+  std::vector<std::thread> threads_;      /**< Prefetch threads */
+};
+
+double percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0.;
+  }
+  const size_t n = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+  std::nth_element(values.begin(), values.begin() + n, values.end());
+  return values[n];
+}
+
+void printLatency(const std::string& name, const std::vector<double>& latencies) {
+  std::printf("%-14s p50 %8.2f ms   p99 %8.2f ms   max %8.2f ms\n", name.c_str(),
+              1e3 * percentile(latencies, 0.5), 1e3 * percentile(latencies, 0.99),
+              latencies.empty() ? 0. : 1e3 * *std::max_element(latencies.begin(), latencies.end()));
+}
+
+int replay(const ReplayOptions& options) {
+  if (!options.tracefile.empty()) {
+    Tracer::Enable();
+    Tracer::WriteOnExit(options.tracefile);
+    Tracer::SetThreadName("Localization");
+  }
+
+  LandmarkMap::ConstPtr map = std::make_shared<const LandmarkMap>(options.map_cfgfile);
+  const LandmarkFinder finder(map);
+  std::unique_ptr<Localizer> localizer;
+  if (options.localizer != "none") {
+    localizer = std::make_unique<CeresLocalizer>(options.cam_cfgfile, map, options.localizer == "ceres2d");
+  }
+
+  BoundedQueue<LoadedFrame> loaded(2 * (options.prefetch_threads + options.parallel_frames));
+  std::mutex detected_mutex;
+  std::condition_variable detected_cv;
+  std::map<size_t, DetectedFrame> detected;  /// reorder buffer, localization runs in frame order
+  size_t detecting_threads = options.parallel_frames;  /// guarded by detected_mutex
+
+  const clock::time_point start = clock::now();
+  FrameSource source(options, loaded);
+
+  /// detection threads, each with its own workspace
+  std::vector<std::thread> detectors;
+  for (size_t t = 0; t < options.parallel_frames; t++) {
+    detectors.emplace_back([&]() {
+      Tracer::SetThreadName("Detection");
+      LandmarkFinder::Workspace workspace;
+      LoadedFrame frame;
+      Backoff backoff;
+      while (true) {
+        if (!loaded.TryPop(frame)) {
+          if (source.isFinished() && loaded.empty()) {
+            break;
+          }
+          backoff.Wait();
+          continue;
+        }
+        backoff.Reset();
+        DetectedFrame result;
+        result.loaded = frame.loaded;
+        const clock::time_point detection_start = clock::now();
+        try {
+          if (!frame.img.empty()) {
+            finder.DetectLandmarks(frame.img, result.landmarks, workspace);
+            result.map = workspace.map;
+          }
+        } catch (const std::exception& e) {
+          std::cerr << "Detection failed in frame " << frame.index << ": " << e.what() << std::endl;
+          result.landmarks.clear();
+        }
+        result.detection_time = std::chrono::duration<double>(clock::now() - detection_start).count();
+        frame.img.release();
+        {
+          std::lock_guard<std::mutex> lock(detected_mutex);
+          detected.emplace(frame.index, std::move(result));
+        }
+        detected_cv.notify_one();
+      }
+      {
+        std::lock_guard<std::mutex> lock(detected_mutex);
+        detecting_threads--;
+      }
+      detected_cv.notify_one();
+    });
+  }
+
+  /// localization in frame order
+  ConfigWriter trajectory;
+  trajectory << "Frames:\n";
+  std::vector<double> latencies, detection_times, localization_times;
+  size_t frames_with_landmarks = 0;
+  size_t landmark_count = 0;
+  const float dt = options.fps > 0. ? static_cast<float>(1. / options.fps) : 0.f;
+  for (size_t index = 0;; index++) {
+    DetectedFrame frame;
+    {
+      std::unique_lock<std::mutex> lock(detected_mutex);
+      detected_cv.wait(lock, [&]() { return detected.count(index) > 0 || detecting_threads == 0; });
+      auto it = detected.find(index);
+      if (it == detected.end()) {
+        break;  // All frames done
+      }
+      frame = std::move(it->second);
+      detected.erase(it);
+    }
+
+    const clock::time_point localization_start = clock::now();
+    pose_t pose = {{0., 0., 0., 0., 0., 0.}};
+    bool has_pose = false;
+    if (localizer && !frame.landmarks.empty()) {
+      try {
+        localizer->UpdatePose(frame.landmarks, dt, frame.map);
+        pose = localizer->getPose();
+        has_pose = true;
+      } catch (const std::exception& e) {
+        std::cerr << "Localization failed in frame " << index << ": " << e.what() << std::endl;
+      }
+    }
+    const clock::time_point localized = clock::now();
+
+    latencies.push_back(std::chrono::duration<double>(localized - frame.loaded).count());
+    detection_times.push_back(frame.detection_time);
+    localization_times.push_back(std::chrono::duration<double>(localized - localization_start).count());
+    frames_with_landmarks += frame.landmarks.empty() ? 0 : 1;
+    landmark_count += frame.landmarks.size();
+
+    // Frames without pose (no landmarks, localization failed) carry no pose fields
+    trajectory << " - { Image: " << source.getName(index);
+    trajectory << ", Valid: " << (has_pose ? "true" : "false");
+    if (has_pose) {
+      trajectory << ", x: " << pose[(int)POSE::X];
+      trajectory << ", y: " << pose[(int)POSE::Y];
+      trajectory << ", z: " << pose[(int)POSE::Z];
+      trajectory << ", rx: " << pose[(int)POSE::Rx];
+      trajectory << ", ry: " << pose[(int)POSE::Ry];
+      trajectory << ", rz: " << pose[(int)POSE::Rz];
+    }
+    trajectory << ", HexIDs: [";
+    for (size_t n = 0; n < frame.landmarks.size(); n++) {
+      trajectory << (n == 0 ? "" : ", ");
+      trajectory.AppendHexId(frame.landmarks[n].nID);
+    }
+    trajectory << "] }\n";
+  }
+  const double wall_time = std::chrono::duration<double>(clock::now() - start).count();
+  for (auto& detector : detectors) {
+    detector.join();
+  }
+  trajectory.Write(options.output);
+
+  const size_t frame_count = latencies.size();
+  std::printf("Frames         %zu in %.2f s, %.1f fps (%zu prefetch, %zu parallel)\n", frame_count, wall_time,
+              wall_time > 0. ? frame_count / wall_time : 0., options.prefetch_threads, options.parallel_frames);
+  std::printf("Detection rate %.1f %% of frames with landmarks, %.2f landmarks per frame\n",
+              frame_count ? 100. * frames_with_landmarks / frame_count : 0.,
+              frame_count ? static_cast<double>(landmark_count) / frame_count : 0.);
+  printLatency("Latency", latencies);
+  printLatency("Detection", detection_times);
+  printLatency("Localization", localization_times);
+  std::printf("Trajectory     %s\n", options.output.c_str());
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ReplayOptions options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    printUsage();
+    return EXIT_FAILURE;
+  }
+  try {
+    return replay(options);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}